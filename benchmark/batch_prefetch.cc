@@ -0,0 +1,94 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "traces/trace_reader.h"
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "random_helper.h"
+
+using namespace std;
+
+// replay the requests on a fresh cache of type cacheType in batches,
+// returns the run time in seconds and the number of hits
+double replay(const string& cacheType, uint64_t cacheSize, size_t distance,
+              const vector<SimpleRequest>& reqs, uint64_t& hits)
+{
+  unique_ptr<Cache> cache = Cache::create_unique(cacheType);
+  if (cache == nullptr)
+    return -1;
+  cache->setSize(cacheSize);
+  cache->setPrefetchDistance(distance);
+
+  vector<uint8_t> hitFlags(TRACE_BATCH_SIZE);
+  hits = 0;
+  const auto start = chrono::steady_clock::now();
+  for (size_t i = 0; i < reqs.size(); i += TRACE_BATCH_SIZE) {
+    const size_t n = min<size_t>(TRACE_BATCH_SIZE, reqs.size() - i);
+    cache->process_batch(&reqs[i], n, hitFlags.data());
+    for (size_t j = 0; j < n; j++)
+      hits += hitFlags[j];
+  }
+  const auto end = chrono::steady_clock::now();
+  return chrono::duration<double>(end - start).count();
+}
+
+// compares process_batch without prefetching (distance 0) to prefetching
+// the hash table slots of the requests distance ahead, on uniformly random
+// requests to more objects than the CPU caches hold. Every cache holds
+// half of the objects (all of size 1)
+int main (int argc, char* argv[])
+{
+  // parameters
+  uint64_t objects = 10000000;
+  uint64_t requests = 20000000;
+  vector<size_t> distances = {0, 4, BATCH_PREFETCH_DISTANCE, 16};
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:d:")) != -1) {
+    switch (opt) {
+    case 'n':
+      objects = stoull(optarg);
+      break;
+    case 'r':
+      requests = stoull(optarg);
+      break;
+    case 'd':
+      distances = {0, stoul(optarg)};
+      break;
+    default:
+      cerr << "\n [-n objects] [-r requests] [-d distance] [cacheType...]\n";
+      return 1;
+    }
+  }
+  vector<string> cacheTypes(argv + optind, argv + argc);
+  if (cacheTypes.empty())
+    cacheTypes = {"LRU", "GDS", "Filter"};
+  if (objects < 2 || requests < 1) {
+    cerr << "invalid number of objects or requests\n";
+    return 1;
+  }
+
+  Xoshiro256 generator;
+  vector<SimpleRequest> reqs;
+  reqs.reserve(requests);
+  for (uint64_t i = 0; i < requests; i++)
+    reqs.push_back(SimpleRequest(generator() % objects, 1));
+
+  cout << "cacheType distance seconds Mreqs/s hits speedup\n";
+  for (const auto& cacheType : cacheTypes) {
+    double baseline = 0;
+    for (const auto distance : distances) {
+      uint64_t hits;
+      const double seconds = replay(cacheType, objects / 2, distance, reqs, hits);
+      if (seconds < 0)
+        return 1;
+      if (distance == 0)
+        baseline = seconds;
+      cout << cacheType << " " << distance << " " << seconds << " "
+           << requests / seconds / 1e6 << " " << hits << " "
+           << baseline / seconds << endl;
+    }
+  }
+  return 0;
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 #include "request.h"
 
 // uncomment to enable cache debugging:
@@ -24,6 +25,8 @@ inline void logMessage(std::string m, double x, double y, double z) {
 #define LOG(m,x,y,z)
 #endif
 
+// requests ahead of the current one whose hash table slots the batch loops prefetch
+const size_t BATCH_PREFETCH_DISTANCE = 8;
 
 
 class Cache;
@@ -39,7 +42,10 @@ public:
     // create and destroy a cache
     Cache()
         : _cacheSize(0),
-          _currentSize(0)
+          _currentSize(0),
+          _traceObjects(0),
+          _denseIds(false),
+          _prefetchDistance(BATCH_PREFETCH_DISTANCE)
     {
     }
     virtual ~Cache(){};
@@ -50,6 +56,13 @@ public:
     virtual void evict(SimpleRequest* req) = 0;
     virtual void evict() = 0;
 
+    // process a batch of requests (lookup, admit on a miss), hitFlags[i] is set to 1 for hits.
+    // SpecializedCache<T> compiles the batch loop for its concrete type, and uses a policy's
+    // own processBatch if it has one (see BatchPolicy)
+    virtual void process_batch(const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        processBatch(*this, reqs, n, hitFlags);
+    }
+
     // configure cache parameters
     virtual void setSize(uint64_t cs) {
         _cacheSize = cs;
@@ -57,7 +70,23 @@ public:
             evict();
         }
     }
-    virtual void setPar(std::string parName, std::string parValue) {}
+    // false if the policy has no parameter parName
+    virtual bool setPar(std::string parName, std::string parValue) {
+        return false;
+    }
+
+    // trace properties known before the simulation starts (webcachesim -d):
+    // the number of distinct object ids, and whether all ids are in [0, objects).
+    // Policies can use this to size their hash tables up front
+    virtual void setTraceInfo(uint64_t objects, bool denseIds) {
+        _traceObjects = objects;
+        _denseIds = denseIds;
+    }
+
+    // requests ahead whose hash table slots process_batch prefetches, 0 to disable
+    void setPrefetchDistance(size_t distance) {
+        _prefetchDistance = distance;
+    }
 
     uint64_t getCurrentSize() const {
         return(_currentSize);
@@ -65,6 +94,29 @@ public:
     uint64_t getSize() const {
         return(_cacheSize);
     }
+    uint64_t getTraceObjects() const {
+        return(_traceObjects);
+    }
+    bool hasDenseIds() const {
+        return(_denseIds);
+    }
+
+    // width of the object ids the policy stores. Ids narrower than 64 bits
+    // need dense ids (webcachesim -d) of a trace with few enough objects
+    virtual unsigned int idBits() const {
+        return 64;
+    }
+    // false, after an error naming the policy, if it cannot store every id of
+    // the trace (see setTraceInfo). Checked before replaying any request
+    bool checkTraceIds(const std::string& name) const {
+        const unsigned int bits = idBits();
+        if (bits >= 64 || (_denseIds && _traceObjects <= (uint64_t(1) << bits))) {
+            return true;
+        }
+        std::cerr << name << " stores " << bits << "-bit object ids, it needs dense ids (-d)"
+                  << " of a trace with at most 2^" << bits << " objects" << std::endl;
+        return false;
+    }
 
     // helper functions (factory pattern)
     static void registerType(std::string name, CacheFactory *factory) {
@@ -81,9 +133,32 @@ public:
     }
 
 protected:
+    // the class whose processBatch replays this policy. A class with its own
+    // processBatch declares itself here, subclasses inherit the typedef and so
+    // fall back to Cache::processBatch unless they declare themselves too
+    // (only when the inherited loop calls all their overrides)
+    typedef Cache BatchPolicy;
+
+    // the batch loop of process_batch, Policy is the static type of cache
+    template<class Policy>
+    static void processBatch(Policy& cache, const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        for (size_t i = 0; i < n; i++) {
+            // policies take requests by pointer, but do not modify them
+            SimpleRequest* req = const_cast<SimpleRequest*>(&reqs[i]);
+            const bool hit = cache.lookup(req);
+            if (!hit) {
+                cache.admit(req);
+            }
+            hitFlags[i] = hit;
+        }
+    }
+
     // basic cache properties
     uint64_t _cacheSize; // size of cache in bytes
     uint64_t _currentSize; // total size of objects in cache in bytes
+    uint64_t _traceObjects; // distinct objects in the trace (0 if unknown)
+    bool _denseIds; // object ids are in [0, _traceObjects)
+    size_t _prefetchDistance; // see setPrefetchDistance
 
     // helper functions (factory pattern)
     static std::map<std::string, CacheFactory *> &get_factory_instance() {
@@ -102,5 +177,40 @@ public:
     }
 };
 
+/*
+  SpecializedCache: a policy whose replay loop is compiled for its type
+
+  the class is final, so in the policy's processBatch instantiated for it
+  the compiler knows the dynamic type and resolves lookup, admit and the
+  policy's internal virtual calls (hit, evict, ageValue, ...) statically,
+  and can inline them. A batch then costs one virtual call instead of
+  several per request. The loop is T::processBatch if T is its own
+  BatchPolicy, Cache::processBatch otherwise.
+
+  process_batch() is instantiated where the policy's member functions are
+  defined: declare "extern template class SpecializedCache<T>;" in the
+  policy's header and "template class SpecializedCache<T>;" in its
+  source file, then register it with a SpecializedFactory<T>.
+*/
+template<class T>
+class SpecializedCache final : public T {
+public:
+    virtual void process_batch(const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        typedef typename std::conditional<std::is_same<typename T::BatchPolicy, T>::value,
+                                          T, Cache>::type Loop;
+        Loop::processBatch(*this, reqs, n, hitFlags);
+    }
+};
+
+template<class T>
+class SpecializedFactory : public CacheFactory {
+public:
+    SpecializedFactory(std::string name) { Cache::registerType(name, this); }
+    std::unique_ptr<Cache> create_unique() {
+        std::unique_ptr<Cache> newT(new SpecializedCache<T>);
+        return newT;
+    }
+};
+
 
 #endif /* CACHE_H */
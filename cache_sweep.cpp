@@ -0,0 +1,184 @@
+#include <cmath>
+#include <exception>
+#include "cache_sweep.h"
+
+CacheSweep::CacheSweep(unsigned int threads, const StatsConfig& config, double sampleRate)
+    : _threads(threads > 0 ? threads : 1),
+      _config(config),
+      _sampleRate(sampleRate),
+      _published(0),
+      _released(0),
+      _stop(false)
+{
+}
+
+CacheSweep::~CacheSweep()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _changed.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void CacheSweep::add(const std::string& name, std::unique_ptr<Cache> cache, uint64_t cacheSize)
+{
+    _runs.push_back(Run(name, std::move(cache), cacheSize, _config, _sampleRate));
+}
+
+void CacheSweep::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    for (auto& run : _runs) {
+        run.cache->setTraceInfo(objects, denseIds);
+    }
+}
+
+bool CacheSweep::checkTraceIds() const
+{
+    for (const auto& run : _runs) {
+        if (!run.cache->checkTraceIds(run.name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CacheSweep::simulate(std::unique_lock<std::mutex>& lock)
+{
+    // the run furthest behind, it holds back the oldest batch
+    Run* run = nullptr;
+    for (auto& r : _runs) {
+        if (!r.busy && r.next < _published && (run == nullptr || r.next < run->next)) {
+            run = &r;
+        }
+    }
+    if (run == nullptr) {
+        return false;
+    }
+    run->busy = true;
+    Slot& slot = _window[run->next % SWEEP_WINDOW];
+    RequestBatch* batch = slot.batch;
+    lock.unlock();
+    try {
+        if (run->error.empty()) {
+            // a sample limited to a number of objects lowers its rate over time,
+            // the caches drop the objects it no longer samples and shrink
+            if (batch->sampleRate != run->sampleRate) {
+                run->sampleRate = batch->sampleRate;
+                for (auto& req : batch->dropped) {
+                    run->cache->evict(&req);
+                }
+                run->cache->setSize(std::max<uint64_t>(1, llround(run->size * run->sampleRate)));
+            }
+            // caches only read requests, so all runs share the batch
+            run->stats.replay(run->cache.get(), batch);
+        }
+    } catch (const std::exception& e) {
+        // e.g. a request a compact cache object cannot hold, the other runs go on
+        run->error = e.what();
+    }
+    lock.lock();
+    run->busy = false;
+    run->next++;
+    if (--slot.pending == 0) {
+        _changed.notify_all();
+    }
+    return true;
+}
+
+void CacheSweep::worker()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop) {
+        if (!simulate(lock)) {
+            _changed.wait(lock);
+        }
+    }
+}
+
+void CacheSweep::drain(std::unique_lock<std::mutex>& lock, RequestPrefetcher& prefetcher,
+                       uint64_t batches)
+{
+    while (true) {
+        while (_released < _published && _window[_released % SWEEP_WINDOW].pending == 0) {
+            prefetcher.release();
+            _released++;
+        }
+        if (_published - _released <= batches) {
+            return;
+        }
+        if (!simulate(lock)) {
+            _changed.wait(lock);
+        }
+    }
+}
+
+bool CacheSweep::run(RequestPrefetcher& prefetcher)
+{
+    // the calling thread simulates, too
+    const size_t workers = std::min<size_t>(_threads, _runs.size()) - 1;
+    while (_workers.size() < workers) {
+        _workers.push_back(std::thread(&CacheSweep::worker, this));
+    }
+    // the ring holds batches of the prefetcher
+    const uint64_t window = std::min(SWEEP_WINDOW, prefetcher.ringSize());
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        drain(lock, prefetcher, window - 1);
+        lock.unlock();
+        RequestBatch* batch = prefetcher.acquire();
+        lock.lock();
+        if (batch == nullptr) {
+            break;
+        }
+        _window[_published % SWEEP_WINDOW] = Slot{batch, _runs.size()};
+        _published++;
+        _sampleRate = batch->sampleRate;
+        _changed.notify_all();
+    }
+    drain(lock, prefetcher, 0);
+    // such a run counted nothing, it reports no results
+    for (auto& run : _runs) {
+        if (run.error.empty() && !run.stats.warm()) {
+            run.error = "the trace ended during the warm-up";
+        }
+    }
+    return prefetcher.good();
+}
+
+void CacheSweep::print(std::ostream& out) const
+{
+    for (const auto& run : _runs) {
+        if (!run.error.empty()) {
+            std::cerr << run.name << ": " << run.error << std::endl;
+            continue;
+        }
+        run.stats.printIntervals(out, run.name);
+        run.stats.printSizeClasses(out, run.name);
+    }
+    for (const auto& run : _runs) {
+        if (!run.error.empty()) {
+            continue;
+        }
+        const HitCounters total = run.stats.total();
+        out << run.name << " " << total.reqs << " " << total.hits << " "
+            << total.objectHitRatio() << " " << total.byteHitRatio();
+        if (_config.sampled) {
+            out << " " << _sampleRate << " " << run.stats.sampleError();
+        }
+        out << std::endl;
+    }
+}
+
+bool CacheSweep::complete() const
+{
+    for (const auto& run : _runs) {
+        if (!run.error.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#ifndef CACHE_SWEEP_H
+#define CACHE_SWEEP_H
+
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "traces/request_prefetcher.h"
+#include "cache.h"
+#include "replay_stats.h"
+
+// batches the fastest cache can run ahead of the slowest one
+const size_t SWEEP_WINDOW = 8;
+
+/*
+  CacheSweep: replays one trace through many cache configurations at once
+
+  the trace is decoded once and every batch is handed to all caches.
+  The last SWEEP_WINDOW batches stay in a ring, each counting the caches
+  that still have to simulate it. Threads claim a cache together with
+  its next batch, so each cache sees the requests in trace order, while
+  fast caches run ahead of slow ones until the ring is full. A batch
+  goes back to the prefetcher once all caches simulated it.
+*/
+class CacheSweep
+{
+protected:
+    struct Run {
+        std::string name; // configuration printed before the results
+        std::unique_ptr<Cache> cache;
+        uint64_t size; // configured cache size, before sampling
+        ReplayStats stats;
+        double sampleRate; // rate the cache is scaled to
+        uint64_t next; // number of batches simulated
+        bool busy; // claimed by a thread
+        std::string error; // why the cache stopped, it skips later batches
+
+        Run(const std::string& name, std::unique_ptr<Cache> cache, uint64_t size,
+            const StatsConfig& config, double sampleRate)
+            : name(name),
+              cache(std::move(cache)),
+              size(size),
+              stats(config),
+              sampleRate(sampleRate),
+              next(0),
+              busy(false)
+        {
+        }
+    };
+
+    struct Slot {
+        RequestBatch* batch;
+        size_t pending; // runs that have not simulated the batch yet
+    };
+
+    std::vector<Run> _runs;
+    unsigned int _threads;
+    StatsConfig _config;
+    double _sampleRate; // rate of the last batch
+    std::vector<std::thread> _workers;
+    Slot _window[SWEEP_WINDOW]; // batch i is in slot i % SWEEP_WINDOW
+    uint64_t _published; // batches handed to the runs
+    uint64_t _released; // batches handed back to the prefetcher
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _changed; // a batch was published or simulated
+
+    void worker();
+    // claim a run whose next batch is published and simulate it, unlocks
+    // in between. false if there is none
+    bool simulate(std::unique_lock<std::mutex>& lock);
+    // simulate until at most batches batches are in the ring, handing
+    // those that all runs simulated back to the prefetcher
+    void drain(std::unique_lock<std::mutex>& lock, RequestPrefetcher& prefetcher,
+               uint64_t batches);
+
+public:
+    // sampleRate: initial rate of a sampled trace (see SampledTraceReader)
+    CacheSweep(unsigned int threads, const StatsConfig& config, double sampleRate = 1.0);
+    ~CacheSweep();
+
+    // cacheSize: configured size, the cache is already scaled to the sampling rate
+    void add(const std::string& name, std::unique_ptr<Cache> cache, uint64_t cacheSize);
+    size_t size() const {
+        return _runs.size();
+    }
+
+    // forwarded to all caches (see Cache::setTraceInfo)
+    void setTraceInfo(uint64_t objects, bool denseIds);
+    // false if a cache cannot store the trace's ids (see Cache::checkTraceIds)
+    bool checkTraceIds() const;
+
+    // replay the whole trace, false if it could not be read completely
+    bool run(RequestPrefetcher& prefetcher);
+
+    // the intervals of all configurations (see ReplayStats::printIntervals),
+    // then one results line per configuration, in the order they were added.
+    // Configurations that stopped with an error only report it
+    void print(std::ostream& out) const;
+    // false if a configuration stopped with an error, or the trace ended
+    // during its warm-up
+    bool complete() const;
+    // why configuration i, counted in the order they were added, has no
+    // results, empty if it has
+    const std::string& error(size_t i) const {
+        return _runs[i].error;
+    }
+    const ReplayStats& stats(size_t i) const {
+        return _runs[i].stats;
+    }
+};
+
+#endif /* CACHE_SWEEP_H */
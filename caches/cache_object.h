@@ -1,57 +1,63 @@
 #ifndef CACHE_HASH_H
 #define CACHE_HASH_H
 
+#include <stdexcept>
 #include "request.h"
+#include "hash.h"
 
 // CacheObject is used by caching policies to store a representation of an "object, i.e., the object's id and its size
-struct CacheObject
+// Id and Size are the widths a policy stores, see CacheObject and CacheObject32 below
+template<class Id, class Size>
+struct BasicCacheObject
 {
-    IdType id;
-    uint64_t size;
+    typedef Id id_type;
+    typedef Size size_type;
 
-    CacheObject(SimpleRequest* req)
+    Id id;
+    Size size;
+
+    BasicCacheObject(const SimpleRequest* req)
         : id(req->getId()),
           size(req->getSize())
+    {
+        // only narrower types can lose bits, the check is compiled out otherwise
+        if (id != req->getId() || size != req->getSize()) {
+            throw std::out_of_range("object id or size does not fit into a compact cache object");
+        }
+    }
+
+    BasicCacheObject(Id id, Size size)
+        : id(id),
+          size(size)
     {}
 
     // comparison is based on all three properties
-    bool operator==(const CacheObject &rhs) const {
+    bool operator==(const BasicCacheObject &rhs) const {
         return (rhs.id == id) && (rhs.size == size);
     }
 };
 
-
-// forward definition of extendable hash
-template <class T>
-void hash_combine(std::size_t & seed, const T & v);
+// the full width of requests
+typedef BasicCacheObject<IdType, uint64_t> CacheObject;
+// half the memory, for dense ids (webcachesim -d) of traces with less than 2^32
+// objects, each smaller than 4 GiB (compact policies such as "LRU32")
+typedef BasicCacheObject<uint32_t, uint32_t> CacheObject32;
 
 
 // definition of a hash function on CacheObjects
-// required to use unordered_map<CacheObject, >
+// required to use FlatMap<CacheObject, > and unordered_map<CacheObject, >
 namespace std
 {
-    template<> struct hash<CacheObject>
+    template<class Id, class Size> struct hash<BasicCacheObject<Id, Size>>
     {
-        inline size_t operator()(const CacheObject cobj) const
+        inline size_t operator()(const BasicCacheObject<Id, Size> cobj) const
         {
-            size_t seed = 0;
-            hash_combine<IdType>(seed, cobj.id);
-            hash_combine<uint64_t>(seed, cobj.size);
-            return seed;
+            // every bit of id and size flips each bit of the hash with probability
+            // about 1/2, so hash tables can use its low bits (FlatMap groups) or
+            // its high bits (LRUTable slots)
+            return mix64(cobj.id ^ mix64(cobj.size));
         }
     };
 }
 
-
-// hash_combine derived from boost/functional/hash/hash.hpp:212
-// Copyright 2005-2014 Daniel James.
-// Distributed under the Boost Software License, Version 1.0.
-// (See http://www.boost.org/LICENSE_1_0.txt)
-template <class T>
-inline void hash_combine(std::size_t & seed, const T & v)
-{
-    std::hash<T> hasher;
-    seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-}
-
 #endif /* CACHE_HASH_H */
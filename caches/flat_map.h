@@ -0,0 +1,351 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <tuple>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// slots whose control bytes are matched at once
+const size_t FLAT_MAP_GROUP = 16;
+
+/*
+  FlatMap: hash map with open addressing in the style of Swiss tables
+
+  entries are stored in one array of slots, next to an array with one
+  control byte per slot: empty, deleted, or 7 bits of the key's hash.
+  A lookup compares the control bytes of a group of 16 slots with SSE2
+  at once and only touches slots whose bits match, groups are probed
+  triangularly until a group with an empty slot. At most 7/8 of the
+  slots are used, so a lookup usually loads one group of control bytes
+  and one slot.
+
+  The interface is the subset of std::unordered_map that the policies
+  use. Unlike there, inserting can move entries (invalidates iterators
+  and references), erasing does not. Iteration order depends on the
+  hash. Needs a hash function with good high and low bits (see
+  std::hash<CacheObject> in cache_object.h).
+*/
+template<class K, class V, class Hash = std::hash<K>>
+class FlatMap
+{
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+
+protected:
+    static const int8_t EMPTY = -128;
+    static const int8_t DELETED = -2;
+
+    int8_t* _ctrl; // FLAT_MAP_GROUP aligned groups
+    value_type* _slots;
+    size_t _capacity; // a power of two, at least FLAT_MAP_GROUP
+    size_t _size;
+    size_t _growthLeft; // empty slots that can be filled before rehashing
+    Hash _hash;
+
+    // slots of a group whose control bytes equal c, as bits
+    static uint32_t match(const int8_t* group, int8_t c) {
+#ifdef __SSE2__
+        const __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < FLAT_MAP_GROUP; i++) {
+            bits |= uint32_t(group[i] == c) << i;
+        }
+        return bits;
+#endif
+    }
+    // empty or deleted slots of a group, as bits
+    static uint32_t matchFree(const int8_t* group) {
+#ifdef __SSE2__
+        const __m128i ctrl = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+        return _mm_movemask_epi8(ctrl);
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < FLAT_MAP_GROUP; i++) {
+            bits |= uint32_t(group[i] < 0) << i;
+        }
+        return bits;
+#endif
+    }
+    static size_t maxLoad(size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    // first group to probe, the low bits of the hash
+    size_t firstGroup(uint64_t hash) const {
+        return hash & (_capacity / FLAT_MAP_GROUP - 1);
+    }
+    // the control byte, the high 7 bits of the hash
+    static int8_t tag(uint64_t hash) {
+        return int8_t(hash >> 57);
+    }
+
+    size_t findSlot(const K& key, uint64_t hash) const {
+        const size_t groups = _capacity / FLAT_MAP_GROUP;
+        const int8_t t = tag(hash);
+        size_t g = firstGroup(hash);
+        for (size_t step = 1; ; step++) {
+            const int8_t* group = _ctrl + g * FLAT_MAP_GROUP;
+            for (uint32_t bits = match(group, t); bits != 0; bits &= bits - 1) {
+                const size_t i = g * FLAT_MAP_GROUP + __builtin_ctz(bits);
+                if (_slots[i].first == key) {
+                    return i;
+                }
+            }
+            if (match(group, EMPTY) != 0) {
+                return _capacity;
+            }
+            // triangular numbers visit every group of a power of two
+            g = (g + step) & (groups - 1);
+        }
+    }
+    // an empty or deleted slot in the probe sequence of hash
+    size_t freeSlot(uint64_t hash) const {
+        const size_t groups = _capacity / FLAT_MAP_GROUP;
+        size_t g = firstGroup(hash);
+        for (size_t step = 1; ; step++) {
+            const uint32_t bits = matchFree(_ctrl + g * FLAT_MAP_GROUP);
+            if (bits != 0) {
+                return g * FLAT_MAP_GROUP + __builtin_ctz(bits);
+            }
+            g = (g + step) & (groups - 1);
+        }
+    }
+
+    void allocate(size_t capacity) {
+        _capacity = capacity;
+        // groups are loaded aligned
+        void* ctrl = nullptr;
+        if (posix_memalign(&ctrl, FLAT_MAP_GROUP, capacity) != 0) {
+            throw std::bad_alloc();
+        }
+        _ctrl = static_cast<int8_t*>(ctrl);
+        std::memset(_ctrl, EMPTY, capacity);
+        _slots = static_cast<value_type*>(::operator new(capacity * sizeof(value_type)));
+        _growthLeft = maxLoad(capacity);
+    }
+    void destroy() {
+        for (size_t i = 0; i < _capacity; i++) {
+            if (_ctrl[i] >= 0) {
+                _slots[i].~value_type();
+            }
+        }
+        free(_ctrl);
+        ::operator delete(_slots);
+    }
+    // move all entries into a table of capacity slots, drops deleted slots
+    void rehash(size_t capacity) {
+        int8_t* oldCtrl = _ctrl;
+        value_type* oldSlots = _slots;
+        const size_t oldCapacity = _capacity;
+        allocate(capacity);
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] < 0) {
+                continue;
+            }
+            const uint64_t hash = _hash(oldSlots[i].first);
+            const size_t j = freeSlot(hash);
+            _ctrl[j] = tag(hash);
+            new (&_slots[j]) value_type(std::move(oldSlots[i]));
+            oldSlots[i].~value_type();
+        }
+        _growthLeft -= _size;
+        free(oldCtrl);
+        ::operator delete(oldSlots);
+    }
+
+    template<class... Args>
+    size_t insertSlot(const K& key, uint64_t hash, Args&&... args) {
+        size_t i = freeSlot(hash);
+        if (_growthLeft == 0 && _ctrl[i] == EMPTY) {
+            // double, or only drop the deleted slots if they use up the space
+            rehash(_size + 1 > maxLoad(_capacity) / 2 ? 2 * _capacity : _capacity);
+            i = freeSlot(hash);
+        }
+        if (_ctrl[i] == EMPTY) {
+            _growthLeft--;
+        }
+        _ctrl[i] = tag(hash);
+        new (&_slots[i]) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+        _size++;
+        return i;
+    }
+
+public:
+    template<class Value, class Map>
+    class Iterator {
+    protected:
+        Map* _map;
+        size_t _i;
+
+        friend class FlatMap;
+
+    public:
+        Iterator(Map* map, size_t i)
+            : _map(map),
+              _i(i)
+        {
+            skip();
+        }
+        // iterator to const_iterator
+        template<class OtherValue, class OtherMap>
+        Iterator(const Iterator<OtherValue, OtherMap>& other)
+            : _map(other._map),
+              _i(other._i)
+        {
+        }
+
+        void skip() {
+            while (_i < _map->_capacity && _map->_ctrl[_i] < 0) {
+                _i++;
+            }
+        }
+        Value& operator*() const {
+            return _map->_slots[_i];
+        }
+        Value* operator->() const {
+            return &_map->_slots[_i];
+        }
+        Iterator& operator++() {
+            _i++;
+            skip();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const Iterator& other) const {
+            return _i == other._i;
+        }
+        bool operator!=(const Iterator& other) const {
+            return _i != other._i;
+        }
+
+        template<class, class> friend class Iterator;
+    };
+    typedef Iterator<value_type, FlatMap> iterator;
+    typedef Iterator<const value_type, const FlatMap> const_iterator;
+
+    FlatMap()
+        : _size(0)
+    {
+        allocate(FLAT_MAP_GROUP);
+    }
+    ~FlatMap() {
+        destroy();
+    }
+    FlatMap(const FlatMap&) = delete;
+    FlatMap& operator=(const FlatMap&) = delete;
+
+    size_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+    // make room for objects entries without rehashing
+    void reserve(size_t objects) {
+        size_t capacity = _capacity;
+        while (maxLoad(capacity) < objects) {
+            capacity *= 2;
+        }
+        if (capacity > _capacity) {
+            rehash(capacity);
+        }
+    }
+    void clear() {
+        for (size_t i = 0; i < _capacity; i++) {
+            if (_ctrl[i] >= 0) {
+                _slots[i].~value_type();
+            }
+        }
+        std::memset(_ctrl, EMPTY, _capacity);
+        _size = 0;
+        _growthLeft = maxLoad(_capacity);
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+    iterator end() {
+        return iterator(this, _capacity);
+    }
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(this, _capacity);
+    }
+
+    iterator find(const K& key) {
+        return iterator(this, findSlot(key, _hash(key)));
+    }
+    const_iterator find(const K& key) const {
+        return const_iterator(this, findSlot(key, _hash(key)));
+    }
+    size_t count(const K& key) const {
+        return findSlot(key, _hash(key)) < _capacity;
+    }
+    // start loading the first group that a lookup of key probes
+    void prefetch(const K& key) const {
+        const uint64_t hash = _hash(key);
+        const size_t i = firstGroup(hash) * FLAT_MAP_GROUP;
+        __builtin_prefetch(_ctrl + i);
+        __builtin_prefetch(_slots + i);
+    }
+
+    // insert an entry constructed from key and args unless key is in the map
+    template<class... Args>
+    std::pair<iterator, bool> emplace(const K& key, Args&&... args) {
+        const uint64_t hash = _hash(key);
+        const size_t i = findSlot(key, hash);
+        if (i < _capacity) {
+            return std::make_pair(iterator(this, i), false);
+        }
+        return std::make_pair(iterator(this, insertSlot(key, hash, std::forward<Args>(args)...)), true);
+    }
+    std::pair<iterator, bool> insert(const value_type& entry) {
+        return emplace(entry.first, entry.second);
+    }
+    V& operator[](const K& key) {
+        return emplace(key).first->second;
+    }
+
+    iterator erase(const_iterator it) {
+        const size_t i = it._i;
+        _slots[i].~value_type();
+        // probes only continue past groups without empty slots
+        const int8_t* group = _ctrl + i / FLAT_MAP_GROUP * FLAT_MAP_GROUP;
+        if (match(group, EMPTY) != 0) {
+            _ctrl[i] = EMPTY;
+            _growthLeft++;
+        } else {
+            _ctrl[i] = DELETED;
+        }
+        _size--;
+        return iterator(this, i + 1);
+    }
+    size_t erase(const K& key) {
+        const size_t i = findSlot(key, _hash(key));
+        if (i == _capacity) {
+            return 0;
+        }
+        erase(const_iterator(this, i));
+        return 1;
+    }
+};
+
+#endif /* FLAT_MAP_H */
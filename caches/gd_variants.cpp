@@ -1,10 +1,16 @@
-#include <unordered_map>
 #include <cassert>
 #include "gd_variants.h"
 
 /*
   GD: greedy dual eviction (base class)
 */
+void GreedyDualBase::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    Cache::setTraceInfo(objects, denseIds);
+    // every cached object has at least one byte
+    _cacheMap.reserve(std::min<uint64_t>(objects, _cacheSize));
+}
+
 bool GreedyDualBase::lookup(SimpleRequest* req)
 {
     CacheObject obj(req);
@@ -103,6 +109,12 @@ long double GDSCache::ageValue(SimpleRequest* req)
 /*
   Greedy Dual Size Frequency policy
 */
+void GDSFCache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    GreedyDualBase::setTraceInfo(objects, denseIds);
+    _reqsMap.reserve(objects);
+}
+
 bool GDSFCache::lookup(SimpleRequest* req)
 {
     bool hit = GreedyDualBase::lookup(req);
@@ -131,22 +143,28 @@ LRUKCache::LRUKCache()
 {
 }
 
-void LRUKCache::setPar(std::string parName, std::string parValue) {
+bool LRUKCache::setPar(std::string parName, std::string parValue) {
     if(parName.compare("k") == 0) {
         const int k = stoi(parValue);
         assert(k>0);
         _tk = k;
     } else {
-        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return false;
     }
+    return true;
 }
 
+void LRUKCache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    GreedyDualBase::setTraceInfo(objects, denseIds);
+    _refsMap.reserve(objects);
+}
 
 bool LRUKCache::lookup(SimpleRequest* req)
 {
     CacheObject obj(req);
     _curTime++;
-    _refsMap[obj].push(_curTime);
+    refs(obj).push(_curTime);
     bool hit = GreedyDualBase::lookup(req);
     return hit;
 }
@@ -177,9 +195,10 @@ long double LRUKCache::ageValue(SimpleRequest* req)
 {
     CacheObject obj(req);
     long double newVal = 0.0L;
-    if(_refsMap[obj].size() >= _tk) {
-        newVal = _refsMap[obj].front();
-        _refsMap[obj].pop();
+    lrukRefsType& objRefs = refs(obj);
+    if(objRefs.size() >= _tk) {
+        newVal = objRefs.front();
+        objRefs.pop();
     }
     //std::cerr << id << " " << _curTime << " " << _refsMap[id].size() << " " << newVal << " " << _currentL << std::endl;
     return newVal;
@@ -188,6 +207,12 @@ long double LRUKCache::ageValue(SimpleRequest* req)
 /*
   LFUDA
 */
+void LFUDACache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    GreedyDualBase::setTraceInfo(objects, denseIds);
+    _reqsMap.reserve(objects);
+}
+
 bool LFUDACache::lookup(SimpleRequest* req)
 {
     bool hit = GreedyDualBase::lookup(req);
@@ -206,3 +231,11 @@ long double LFUDACache::ageValue(SimpleRequest* req)
     return _currentL + _reqsMap[obj];
 }
 
+/*
+  replay loops specialized for each policy (see SpecializedCache in cache.h)
+*/
+template class SpecializedCache<GreedyDualBase>;
+template class SpecializedCache<GDSCache>;
+template class SpecializedCache<GDSFCache>;
+template class SpecializedCache<LRUKCache>;
+template class SpecializedCache<LFUDACache>;
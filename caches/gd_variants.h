@@ -1,16 +1,19 @@
 #ifndef GD_VARIANTS_H
 #define GD_VARIANTS_H
 
-#include <unordered_map>
 #include <map>
 #include <queue>
 #include "cache.h"
 #include "cache_object.h"
+#include "flat_map.h"
+#include "memory_pool.h"
 
-typedef std::multimap<long double, CacheObject> ValueMapType;
+// the policies' node-based containers take their nodes from the cache's MemoryPool
+typedef std::multimap<long double, CacheObject, std::less<long double>,
+                      PoolAllocator<std::pair<const long double, CacheObject>>> ValueMapType;
 typedef ValueMapType::iterator ValueMapIteratorType;
-typedef std::unordered_map<CacheObject, ValueMapIteratorType> GdCacheMapType;
-typedef std::unordered_map<CacheObject, uint64_t> CacheStatsMapType;
+typedef FlatMap<CacheObject, ValueMapIteratorType> GdCacheMapType;
+typedef FlatMap<CacheObject, uint64_t> CacheStatsMapType;
 
 /*
   GD: greedy dual eviction (base class)
@@ -22,9 +25,11 @@ class GreedyDualBase : public Cache
 protected:
     // the GD current value
     long double _currentL = 0;
+    // memory of the containers below and those of subclasses, declared first to outlive them
+    MemoryPool _pool;
     // ordered multi map of GD values, access object id + size
     ValueMapType _valueMap;
-    // find objects via unordered_map
+    // find objects via hash map
     GdCacheMapType _cacheMap;
 
     virtual long double ageValue(SimpleRequest* req);
@@ -33,20 +38,68 @@ protected:
 public:
     GreedyDualBase()
         : Cache(),
-          _currentL(0)
+          _currentL(0),
+          _valueMap(ValueMapType::key_compare(), ValueMapType::allocator_type(&_pool))
     {
     }
     virtual ~GreedyDualBase()
     {
     }
 
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
+
+protected:
+    // processBatch below replays this class (see SpecializedCache), subclasses
+    // that override lookup, admit or hit inherit this and get Cache::processBatch
+    typedef GreedyDualBase BatchPolicy;
+
+    // lookup, hit and admit with one hash table probe per request: a miss inserts
+    // the object's entry right away and sets its value after the evictions.
+    // The slots of the request _prefetchDistance ahead are prefetched first.
+    template<class Policy>
+    static void processBatch(Policy& cache, const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        const size_t ahead = cache._prefetchDistance;
+        for (size_t i = 0; i < n; i++) {
+            if (ahead > 0 && i + ahead < n) {
+                cache._cacheMap.prefetch(CacheObject(&reqs[i + ahead]));
+            }
+            SimpleRequest* req = const_cast<SimpleRequest*>(&reqs[i]);
+            CacheObject obj(req);
+            const GdCacheMapType::value_type item(obj, ValueMapIteratorType());
+            auto entry = cache._cacheMap.insert(item);
+            if (!entry.second) {
+                LOG("h", 0, obj.id, obj.size);
+                // update the object's value, as in hit()
+                cache._valueMap.erase(entry.first->second);
+                entry.first->second = cache._valueMap.emplace(cache.ageValue(req), entry.first->first);
+                hitFlags[i] = 1;
+                continue;
+            }
+            hitFlags[i] = 0;
+            // object feasible to store?
+            if (obj.size >= cache._cacheSize) {
+                LOG("error", cache._cacheSize, obj.id, obj.size);
+                cache._cacheMap.erase(entry.first);
+                continue;
+            }
+            // evictions erase other entries only, entry stays valid
+            while (cache._currentSize + obj.size > cache._cacheSize) {
+                cache.evict();
+            }
+            long double ageVal = cache.ageValue(req);
+            LOG("a", ageVal, obj.id, obj.size);
+            entry.first->second = cache._valueMap.emplace(ageVal, obj);
+            cache._currentSize += obj.size;
+        }
+    }
 };
 
-static Factory<GreedyDualBase> factoryGD("GD");
+extern template class SpecializedCache<GreedyDualBase>;
+static SpecializedFactory<GreedyDualBase> factoryGD("GD");
 
 /*
   Greedy Dual Size policy
@@ -54,6 +107,11 @@ static Factory<GreedyDualBase> factoryGD("GD");
 class GDSCache : public GreedyDualBase
 {
 protected:
+    // only ageValue differs, so GreedyDualBase::processBatch replays GDS too
+    // and calls ageValue on the concrete cache
+    typedef GDSCache BatchPolicy;
+    friend class GreedyDualBase;
+
     virtual long double ageValue(SimpleRequest* req);
 
 public:
@@ -66,7 +124,8 @@ public:
     }
 };
 
-static Factory<GDSCache> factoryGDS("GDS");
+extern template class SpecializedCache<GDSCache>;
+static SpecializedFactory<GDSCache> factoryGDS("GDS");
 
 /*
   Greedy Dual Size Frequency policy
@@ -87,15 +146,18 @@ public:
     {
     }
 
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
 };
 
-static Factory<GDSFCache> factoryGDSF("GDSF");
+extern template class SpecializedCache<GDSFCache>;
+static SpecializedFactory<GDSFCache> factoryGDSF("GDSF");
 
 /*
   LRU-K policy
 */
-typedef std::unordered_map<CacheObject, std::queue<uint64_t>> lrukMapType;
+typedef std::queue<uint64_t, std::deque<uint64_t, PoolAllocator<uint64_t>>> lrukRefsType;
+typedef FlatMap<CacheObject, lrukRefsType> lrukMapType;
 
 class LRUKCache : public GreedyDualBase
 {
@@ -105,6 +167,10 @@ protected:
     uint64_t _curTime;
 
     virtual long double ageValue(SimpleRequest* req);
+    // reference times of obj, a new queue on the pool if there are none
+    lrukRefsType& refs(const CacheObject& obj) {
+        return _refsMap.emplace(obj, lrukRefsType::container_type::allocator_type(&_pool)).first->second;
+    }
 
 public:
     LRUKCache();
@@ -112,13 +178,15 @@ public:
     {
     }
 
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool setPar(std::string parName, std::string parValue);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
 };
 
-static Factory<LRUKCache> factoryLRUK("LRUK");
+extern template class SpecializedCache<LRUKCache>;
+static SpecializedFactory<LRUKCache> factoryLRUK("LRUK");
 
 /*
   LFUDA
@@ -139,9 +207,11 @@ public:
     {
     }
 
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
 };
 
-static Factory<LFUDACache> factoryLFUDA("LFUDA");
+extern template class SpecializedCache<LFUDACache>;
+static SpecializedFactory<LFUDACache> factoryLFUDA("LFUDA");
 
 #endif /* GD_VARIANTS_H */
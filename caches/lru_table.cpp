@@ -0,0 +1,128 @@
+#include <stdexcept>
+#include "lru_table.h"
+
+// slots of an empty table
+const uint64_t LRU_TABLE_MIN_SLOTS = 16;
+// indices up to FREE are reserved
+const uint64_t LRU_TABLE_MAX_SLOTS = uint64_t(1) << 31;
+
+template<class Object>
+BasicLRUTable<Object>::BasicLRUTable()
+    : _slots(LRU_TABLE_MIN_SLOTS),
+      _mask(LRU_TABLE_MIN_SLOTS - 1),
+      _shift(64 - __builtin_ctzll(LRU_TABLE_MIN_SLOTS)),
+      _size(0),
+      _head(NIL),
+      _tail(NIL)
+{
+}
+
+template<class Object>
+void BasicLRUTable<Object>::unlink(Index i)
+{
+    Slot& slot = _slots[i];
+    if (slot.prev == NIL) {
+        _head = slot.next;
+    } else {
+        _slots[slot.prev].next = slot.next;
+    }
+    if (slot.next == NIL) {
+        _tail = slot.prev;
+    } else {
+        _slots[slot.next].prev = slot.prev;
+    }
+}
+
+template<class Object>
+void BasicLRUTable<Object>::linkFront(Index i)
+{
+    Slot& slot = _slots[i];
+    slot.prev = NIL;
+    slot.next = _head;
+    if (_head == NIL) {
+        _tail = i;
+    } else {
+        _slots[_head].prev = i;
+    }
+    _head = i;
+}
+
+template<class Object>
+void BasicLRUTable<Object>::rehash(uint64_t slots)
+{
+    if (slots > LRU_TABLE_MAX_SLOTS) {
+        throw std::length_error("LRUTable: too many objects");
+    }
+    std::vector<Slot> old(slots);
+    old.swap(_slots);
+    _mask = slots - 1;
+    _shift = 64 - __builtin_ctzll(slots);
+    _size = 0;
+    // least recently used first, each pushFront puts the next one before it
+    Index i = _tail;
+    _head = _tail = NIL;
+    for (; i != NIL; i = old[i].prev) {
+        pushFront(Object(old[i].id, old[i].size));
+    }
+}
+
+template<class Object>
+void BasicLRUTable<Object>::reserve(uint64_t objects)
+{
+    uint64_t slots = _slots.size();
+    while (slots < 2 * objects && slots < LRU_TABLE_MAX_SLOTS) {
+        slots *= 2;
+    }
+    if (slots > _slots.size()) {
+        rehash(slots);
+    }
+}
+
+template<class Object>
+typename BasicLRUTable<Object>::Index BasicLRUTable<Object>::pushFront(const Object& obj)
+{
+    if (2 * (_size + 1) > _slots.size()) {
+        rehash(2 * _slots.size());
+    }
+    Index i = home(obj);
+    while (_slots[i].prev != FREE) {
+        i = (i + 1) & _mask;
+    }
+    _slots[i].id = obj.id;
+    _slots[i].size = obj.size;
+    linkFront(i);
+    _size++;
+    return i;
+}
+
+template<class Object>
+void BasicLRUTable<Object>::erase(Index i)
+{
+    unlink(i);
+    _size--;
+    // move later slots of the probe run into the hole, unless that puts them before their home
+    Index hole = i;
+    for (Index j = (i + 1) & _mask; _slots[j].prev != FREE; j = (j + 1) & _mask) {
+        const Index h = home(_slots[j]);
+        if (((j - h) & _mask) < ((j - hole) & _mask)) {
+            continue;
+        }
+        Slot& slot = _slots[hole];
+        slot = _slots[j];
+        if (slot.prev == NIL) {
+            _head = hole;
+        } else {
+            _slots[slot.prev].next = hole;
+        }
+        if (slot.next == NIL) {
+            _tail = hole;
+        } else {
+            _slots[slot.next].prev = hole;
+        }
+        hole = j;
+    }
+    _slots[hole].prev = FREE;
+}
+
+template class BasicLRUTable<CacheObject>;
+template class BasicLRUTable<CacheObject32>;
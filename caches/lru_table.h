@@ -0,0 +1,115 @@
+#ifndef LRU_TABLE_H
+#define LRU_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "cache_object.h"
+
+/*
+  LRUTable: objects in recency order, stored in one open-addressing hash table
+
+  every slot holds an object and the 32-bit indices of its neighbors in
+  the recency list. Finding, moving and evicting an object touch only
+  the table, admitting one allocates nothing unless the table doubles.
+  Linear probing with backward shift deletion: erasing an object moves
+  the later slots of its probe run back and relinks their neighbors, so
+  slot indices are valid until the next pushFront or erase.
+  Object is CacheObject, or CacheObject32 for 16-byte instead of 24-byte slots.
+*/
+template<class Object>
+class BasicLRUTable
+{
+public:
+    typedef uint32_t Index;
+    static const Index NIL = UINT32_MAX; // end of the list, or not found
+
+protected:
+    static const Index FREE = UINT32_MAX - 1; // prev of a free slot
+
+    struct Slot {
+        typename Object::id_type id;
+        typename Object::size_type size;
+        Index prev; // more recently used neighbor, FREE for a free slot
+        Index next; // less recently used neighbor
+
+        Slot()
+            : id(0),
+              size(0),
+              prev(FREE),
+              next(NIL)
+        {
+        }
+    };
+
+    std::vector<Slot> _slots; // a power of two, at most half of them used
+    uint64_t _mask;
+    unsigned int _shift; // 64 - log2(_slots.size())
+    uint64_t _size;
+    Index _head; // most recently used
+    Index _tail; // least recently used
+
+    // first slot to probe for obj, the high bits of std::hash<Object>
+    Index home(const Object& obj) const {
+        return std::hash<Object>()(obj) >> _shift;
+    }
+    Index home(const Slot& slot) const {
+        return home(Object(slot.id, slot.size));
+    }
+    void unlink(Index i);
+    void linkFront(Index i);
+    // rebuild with slots slots, keeping the recency order
+    void rehash(uint64_t slots);
+
+public:
+    BasicLRUTable();
+
+    // make room for objects objects without rehashing
+    void reserve(uint64_t objects);
+
+    uint64_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+    // least recently used object, NIL if empty
+    Index back() const {
+        return _tail;
+    }
+    Object object(Index i) const {
+        return Object(_slots[i].id, _slots[i].size);
+    }
+
+    // slot of obj, NIL if it is not in the table
+    Index find(const Object& obj) const {
+        for (Index i = home(obj); _slots[i].prev != FREE; i = (i + 1) & _mask) {
+            if (_slots[i].id == obj.id && _slots[i].size == obj.size) {
+                return i;
+            }
+        }
+        return NIL;
+    }
+    // start loading the first slot that find(obj) probes
+    void prefetch(const Object& obj) const {
+        __builtin_prefetch(&_slots[home(obj)]);
+    }
+
+    // insert obj, which is not in the table, as the most recently used object
+    Index pushFront(const Object& obj);
+    void moveToFront(Index i) {
+        if (i != _head) {
+            unlink(i);
+            linkFront(i);
+        }
+    }
+    void erase(Index i);
+};
+
+// instantiated in lru_table.cpp
+extern template class BasicLRUTable<CacheObject>;
+extern template class BasicLRUTable<CacheObject32>;
+typedef BasicLRUTable<CacheObject> LRUTable;
+typedef BasicLRUTable<CacheObject32> LRUTable32;
+
+#endif /* LRU_TABLE_H */
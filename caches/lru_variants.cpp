@@ -1,4 +1,3 @@
-#include <unordered_map>
 #include <limits>
 #include <cmath>
 #include <cassert>
@@ -33,22 +32,32 @@ static inline double oP2(double T, double l, double p) {
 /*
   LRU: Least Recently Used eviction
 */
-bool LRUCache::lookup(SimpleRequest* req)
+template<class Object>
+void BasicLRUCache<Object>::setTraceInfo(uint64_t objects, bool denseIds)
 {
-    // CacheObject: defined in cache_object.h 
-    CacheObject obj(req);
-    // _cacheMap defined in class LRUCache in lru_variants.h 
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
+    Cache::setTraceInfo(objects, denseIds);
+    // every cached object has at least one byte
+    _cacheTable.reserve(std::min<uint64_t>(objects, _cacheSize));
+}
+
+template<class Object>
+bool BasicLRUCache<Object>::lookup(SimpleRequest* req)
+{
+    // Object: CacheObject or CacheObject32, defined in cache_object.h
+    Object obj(req);
+    // _cacheTable defined in class BasicLRUCache in lru_variants.h
+    const typename Table::Index slot = _cacheTable.find(obj);
+    if (slot != Table::NIL) {
         // log hit
         LOG("h", 0, obj.id, obj.size);
-        hit(it, obj.size);
+        hit(slot, obj.size);
         return true;
     }
     return false;
 }
 
-void LRUCache::admit(SimpleRequest* req)
+template<class Object>
+void BasicLRUCache<Object>::admit(SimpleRequest* req)
 {
     const uint64_t size = req->getSize();
     // object feasible to store?
@@ -61,69 +70,70 @@ void LRUCache::admit(SimpleRequest* req)
         evict();
     }
     // admit new object
-    CacheObject obj(req);
-    _cacheList.push_front(obj);
-    _cacheMap[obj] = _cacheList.begin();
+    Object obj(req);
+    _cacheTable.pushFront(obj);
     _currentSize += size;
     LOG("a", _currentSize, obj.id, obj.size);
 }
 
-void LRUCache::evict(SimpleRequest* req)
+template<class Object>
+void BasicLRUCache<Object>::evict(SimpleRequest* req)
 {
-    CacheObject obj(req);
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
-        ListIteratorType lit = it->second;
+    Object obj(req);
+    const typename Table::Index slot = _cacheTable.find(obj);
+    if (slot != Table::NIL) {
         LOG("e", _currentSize, obj.id, obj.size);
         _currentSize -= obj.size;
-        _cacheMap.erase(obj);
-        _cacheList.erase(lit);
+        _cacheTable.erase(slot);
     }
 }
 
-SimpleRequest* LRUCache::evict_return()
+template<class Object>
+bool BasicLRUCache<Object>::evict_return(SimpleRequest& victim)
 {
     // evict least popular (i.e. last element)
-    if (_cacheList.size() > 0) {
-        ListIteratorType lit = _cacheList.end();
-        lit--;
-        CacheObject obj = *lit;
+    if (!_cacheTable.empty()) {
+        const typename Table::Index slot = _cacheTable.back();
+        Object obj = _cacheTable.object(slot);
         LOG("e", _currentSize, obj.id, obj.size);
-        SimpleRequest* req = new SimpleRequest(obj.id, obj.size);
+        victim.reinit(obj.id, obj.size);
         _currentSize -= obj.size;
-        _cacheMap.erase(obj);
-        _cacheList.erase(lit);
-        return req;
+        _cacheTable.erase(slot);
+        return true;
     }
-    return NULL;
+    return false;
 }
 
-void LRUCache::evict()
+template<class Object>
+void BasicLRUCache<Object>::evict()
 {
-    evict_return();
+    SimpleRequest victim;
+    evict_return(victim);
 }
 
 
 
-// const_iterator: a forward iterator to const value_type, where 
-// value_type is pair<const key_type, mapped_type>
-void LRUCache::hit(lruCacheMapType::const_iterator it, uint64_t size)
+// slot: the object's slot in _cacheTable, valid until the next insert or erase
+template<class Object>
+void BasicLRUCache<Object>::hit(typename Table::Index slot, uint64_t size)
 {
-    // transfers it->second (i.e., ObjInfo) from _cacheList into 
-    // 	*this. The transferred it->second is to be inserted before 
-    // 	the element pointed to by _cacheList.begin()
-    //
-    // _cacheList is defined in class LRUCache in lru_variants.h 
-    _cacheList.splice(_cacheList.begin(), _cacheList, it->second);
+    // the object becomes the most recently used one
+    _cacheTable.moveToFront(slot);
 }
 
 /*
   FIFO: First-In First-Out eviction
 */
-void FIFOCache::hit(lruCacheMapType::const_iterator it, uint64_t size)
+template<class Object>
+void BasicFIFOCache<Object>::hit(typename BasicLRUCache<Object>::Table::Index slot, uint64_t size)
 {
 }
 
+template class BasicLRUCache<CacheObject>;
+template class BasicLRUCache<CacheObject32>;
+template class BasicFIFOCache<CacheObject>;
+template class BasicFIFOCache<CacheObject32>;
+
 /*
   FilterCache (admit only after N requests)
 */
@@ -133,16 +143,23 @@ FilterCache::FilterCache()
 {
 }
 
-void FilterCache::setPar(std::string parName, std::string parValue) {
+bool FilterCache::setPar(std::string parName, std::string parValue) {
     if(parName.compare("n") == 0) {
         const uint64_t n = std::stoull(parValue);
         assert(n>0);
         _nParam = n;
     } else {
-        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return false;
     }
+    return true;
 }
 
+void FilterCache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    LRUCache::setTraceInfo(objects, denseIds);
+    // the filter tracks every object
+    _filter.reserve(objects);
+}
 
 bool FilterCache::lookup(SimpleRequest* req)
 {
@@ -170,14 +187,15 @@ ThLRUCache::ThLRUCache()
 {
 }
 
-void ThLRUCache::setPar(std::string parName, std::string parValue) {
+bool ThLRUCache::setPar(std::string parName, std::string parValue) {
     if(parName.compare("t") == 0) {
         const double t = stof(parValue);
         assert(t>0);
         _sizeThreshold = pow(2.0,t);
     } else {
-        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return false;
     }
+    return true;
 }
 
 
@@ -200,14 +218,17 @@ ExpLRUCache::ExpLRUCache()
 {
 }
 
-void ExpLRUCache::setPar(std::string parName, std::string parValue) {
+bool ExpLRUCache::setPar(std::string parName, std::string parValue) {
     if(parName.compare("c") == 0) {
         const double c = stof(parValue);
         assert(c>0);
         _cParam = pow(2.0,c);
+    } else if(parName.compare("seed") == 0) {
+        _generator.seed(stoull(parValue));
     } else {
-        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return false;
     }
+    return true;
 }
 
 
@@ -217,8 +238,7 @@ void ExpLRUCache::admit(SimpleRequest* req)
     const double size = req->getSize();
     // admit to cache with probablity that is exponentially decreasing with size
     double admissionProb = exp(-size/ _cParam);
-    std::bernoulli_distribution distribution(admissionProb);
-    if (distribution(globalGenerator)) {
+    if (_generator() < probabilityThreshold(admissionProb)) {
         LRUCache::admit(req);
     }
 }
@@ -235,7 +255,7 @@ AdaptSizeCache::AdaptSizeCache()
     _gss_v=1.0-gss_r; // golden section search book parameters
 }
 
-void AdaptSizeCache::setPar(std::string parName, std::string parValue) {
+bool AdaptSizeCache::setPar(std::string parName, std::string parValue) {
     if(parName.compare("t") == 0) {
         const uint64_t t = stoull(parValue);
         assert(t>1);
@@ -244,9 +264,19 @@ void AdaptSizeCache::setPar(std::string parName, std::string parValue) {
         const uint64_t i = stoull(parValue);
         assert(i>1);
         _maxIterations = i;
+    } else if(parName.compare("seed") == 0) {
+        _generator.seed(stoull(parValue));
     } else {
-        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return false;
     }
+    return true;
+}
+
+void AdaptSizeCache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    LRUCache::setTraceInfo(objects, denseIds);
+    _longTermMetadata.reserve(objects);
+    _intervalMetadata.reserve(std::min<uint64_t>(objects, _reconfiguration_interval));
 }
 
 bool AdaptSizeCache::lookup(SimpleRequest* req)
@@ -288,10 +318,9 @@ bool AdaptSizeCache::lookup(SimpleRequest* req)
 
 void AdaptSizeCache::admit(SimpleRequest* req)
 {
-    double roll = _uniform_real_distribution(globalGenerator);
     double admitProb = std::exp(-1.0 * double(req->getSize())/_cParam); 
 
-    if(roll < admitProb) 
+    if(_generator() < probabilityThreshold(admitProb)) 
         LRUCache::admit(req); 
 }
 
@@ -501,15 +530,31 @@ double AdaptSizeCache::modelHitRate(double log2c) {
 */
 
 void S4LRUCache::setSize(uint64_t cs) {
+    _cacheSize = cs;
     uint64_t total = cs;
     for(int i=0; i<4; i++) {
         segments[i].setSize(cs/4);
         total -= cs/4;
-        std::cerr << "setsize " << i << " : " << cs/4 << "\n";
     }
     if(total>0) {
         segments[0].setSize(cs/4+total);
-        std::cerr << "bonus setsize " << 0 << " : " << cs/4 + total << "\n";
+    }
+    updateCurrentSize();
+}
+
+void S4LRUCache::updateCurrentSize()
+{
+    _currentSize = 0;
+    for(int i=0; i<4; i++) {
+        _currentSize += segments[i].getCurrentSize();
+    }
+}
+
+void S4LRUCache::setTraceInfo(uint64_t objects, bool denseIds)
+{
+    Cache::setTraceInfo(objects, denseIds);
+    for(int i=0; i<4; i++) {
+        segments[i].setTraceInfo(objects, denseIds);
     }
 }
 
@@ -522,6 +567,7 @@ bool S4LRUCache::lookup(SimpleRequest* req)
                 // move up
                 segments[i].evict(req);
                 segment_admit(i+1,req);
+                updateCurrentSize();
             }
             return true;
         }
@@ -532,6 +578,7 @@ bool S4LRUCache::lookup(SimpleRequest* req)
 void S4LRUCache::admit(SimpleRequest* req)
 {
     segments[0].admit(req);
+    updateCurrentSize();
 }
 
 void S4LRUCache::segment_admit(uint8_t idx, SimpleRequest* req)
@@ -539,12 +586,14 @@ void S4LRUCache::segment_admit(uint8_t idx, SimpleRequest* req)
     if(idx==0) {
         segments[idx].admit(req);
     } else {
+        SimpleRequest victim;
         while(segments[idx].getCurrentSize() + req->getSize()
               > segments[idx].getSize()) {
             // need to evict from this partition first
             // find least popular item in this segment
-            auto nreq = segments[idx].evict_return();
-            segment_admit(idx-1,nreq);
+            if(!segments[idx].evict_return(victim))
+                break;
+            segment_admit(idx-1,&victim);
         }
         segments[idx].admit(req);
     }
@@ -555,11 +604,13 @@ void S4LRUCache::evict(SimpleRequest* req)
     for(int i=0; i<4; i++) {
         segments[i].evict(req);
     }
+    updateCurrentSize();
 }
 
 void S4LRUCache::evict()
 {
     segments[0].evict();
+    updateCurrentSize();
 }
 
 //######################################################################
@@ -599,13 +650,13 @@ bool TinyLFU::lookup(SimpleRequest* req)
     CacheObject obj(req);
     // Update the TinyLFU with the new object
     update_tiny_lfu(obj.id);
-    // _cacheMap defined in class LRUCache in lru_variants.h 
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
+    // _cacheTable defined in class LRUCache in lru_variants.h 
+    const LRUTable::Index slot = _cacheTable.find(obj);
+    if (slot != LRUTable::NIL) {
         // log hit
         LOG("h", 0, obj.id, obj.size);
 
-        hit(it, obj.size);
+        hit(slot, obj.size);
         return true;
     }
     return false;
@@ -635,8 +686,7 @@ void TinyLFU::admit(SimpleRequest* req)
     // admit new object
     if (evicted) {
         CacheObject obj(req);
-        _cacheList.push_front(obj);
-        _cacheMap[obj] = _cacheList.begin();
+        _cacheTable.pushFront(obj);
         _currentSize += size;
         LOG("a", _currentSize, obj.id, obj.size);
         // Update the TinyLFU with the new object
@@ -649,33 +699,32 @@ void TinyLFU::admit(SimpleRequest* req)
  *              if it's frequancy is smaller than the object with ID cand_id
  *              otherwise it doesn't add the object with the ID cand_id to the cache.
  * @param       cand_id    The ID of an object.
- * @result      A pointer to the request of an object that has been evicted by the function.
+ * @param       victim     Set to the evicted object.
+ * @result      true if an object has been evicted by the function, false otherwise.
 */
-SimpleRequest* TinyLFU::evict_return(int cand_id)
+bool TinyLFU::evict_return(int cand_id, SimpleRequest& victim)
 {
     // evict least popular (i.e. last element)
-    if (_cacheList.size() > 0) {
-        ListIteratorType lit = _cacheList.end();
-        lit--;
-        CacheObject obj = *lit;
+    if (!_cacheTable.empty()) {
+        const LRUTable::Index slot = _cacheTable.back();
+        CacheObject obj = _cacheTable.object(slot);
         LOG("e", _currentSize, obj.id, obj.size);
-        SimpleRequest* req = new SimpleRequest(obj.id, obj.size);
 
         //  compare the victim with the candidate to choose which to be evicted. We use the CM Sketch to decide
         int victim_freq_est = CM_PointEst(cm_sketch, obj.id);
         int candidate_freq_est = CM_PointEst(cm_sketch, cand_id);
 
         if (victim_freq_est < candidate_freq_est) {
+            victim.reinit(obj.id, obj.size);
             _currentSize -= obj.size;
-            _cacheMap.erase(obj);
-            _cacheList.erase(lit);
-            return req;
+            _cacheTable.erase(slot);
+            return true;
         }
         else {
-            return NULL;
+            return false;
         }   
     }
-    return NULL;
+    return false;
 }
 /*!
  * @function    evict.
@@ -687,8 +736,8 @@ SimpleRequest* TinyLFU::evict_return(int cand_id)
 */
 bool TinyLFU::evict(int cand_id)
 {
-    //TODO: should delete returned req from evict_return. MEM LEAK
-    return ((evict_return(cand_id) == NULL) ? false : true);
+    SimpleRequest victim;
+    return evict_return(cand_id, victim);
 }
 
 //######################################################################
@@ -719,6 +768,17 @@ void SLRUCache::setSize(uint64_t cs) {
     }
     _cacheSize=cs;
 }
+/*!
+ * @function    setTraceInfo.
+ * @abstract    Passes the trace properties on to both segments.
+ * @param       objects    The number of distinct objects in the trace.
+ * @param       denseIds   true if the ids are in [0, objects).
+*/
+void SLRUCache::setTraceInfo(uint64_t objects, bool denseIds) {
+    Cache::setTraceInfo(objects, denseIds);
+    segments[0].setTraceInfo(objects, denseIds);
+    segments[1].setTraceInfo(objects, denseIds);
+}
 /*!
  * @function    initDoor_initCM.
  * @abstract    Initial the door keeper and the cm_sketch.
@@ -788,26 +848,26 @@ void SLRUCache::admit_from_window(SimpleRequest* req)
         LOG("L", _cacheSize, req->getId(), size);
         return;
     }
-    // check eviction needed
-    SimpleRequest* evicted=NULL,*prevEvicted=NULL;
+    // check eviction needed, the last victim competes with the candidate
+    SimpleRequest prevEvicted;
+    bool evicted=false;
     while (segments[0].getCurrentSize() + size >segments[0].getSize()) {
-        evicted = segments[0].evict_return();
-		if(evicted==NULL) break;
-        prevEvicted=evicted;
+		if(!segments[0].evict_return(prevEvicted)) break;
+        evicted=true;
         // which to evict ? how to evict ? how to compare between victim and candidate
         // what if we need to evict more than one object
     }
 
     // admit new object
-    if (prevEvicted!=NULL) {
+    if (evicted) {
         LOG("a", _currentSize, obj.id, obj.size);
-        int victim_freq_est = CM_PointEst(cm_sketch, prevEvicted->getId())+Door_keeper_PointEst(dk,prevEvicted->getId());
+        int victim_freq_est = CM_PointEst(cm_sketch, prevEvicted.getId())+Door_keeper_PointEst(dk,prevEvicted.getId());
         int candidate_freq_est = CM_PointEst(cm_sketch, req->getId())+Door_keeper_PointEst(dk,req->getId());
 
         // Update the TinyLFU with the new object
 
         if (victim_freq_est > candidate_freq_est) {
-            segments[0].admit(prevEvicted);
+            segments[0].admit(&prevEvicted);
         }
         else {
           segments[0].admit(req);
@@ -832,12 +892,14 @@ void SLRUCache::segment_admit(uint8_t idx, SimpleRequest* req)
     if(idx==0) {
         segments[idx].admit(req);
     } else {
+        SimpleRequest victim;
         while(segments[idx].getCurrentSize() + req->getSize()
               > segments[idx].getSize()) {
             // need to evict from this partition first
             // find least popular item in this segment
-            auto nreq = segments[idx].evict_return();
-            segment_admit(idx-1,nreq);
+            if(!segments[idx].evict_return(victim))
+                break;
+            segment_admit(idx-1,&victim);
         }
         segments[idx].admit(req);
     }
@@ -902,13 +964,14 @@ int SLRUCache::search_door_keeper(long long id) {
  * @abstract    Evict least popular (i.e. last element) from desired segment.
  * @discussion  This function evicts the LRU object in the segment with index segment in the main cache.
  * @param       segment    The index of asegment in the main cache.
- * @result      A pointer to the object that has been removed from the segment.
+ * @param       victim     Set to the object that has been removed from the segment.
+ * @result      true if an object has been removed, false if the segment is empty.
 */
-SimpleRequest* SLRUCache::evict_return(int segment) {
+bool SLRUCache::evict_return(int segment, SimpleRequest& victim) {
 // evict least popular (i.e. last element) from desired segment
-    SimpleRequest* req =  segments[segment].evict_return();
+    const bool evicted = segments[segment].evict_return(victim);
     _currentSize=segments[0].getCurrentSize()+segments[1].getCurrentSize();
-    return req;
+    return evicted;
 
 }
 /*!
@@ -945,27 +1008,27 @@ int SLRUCache::getSegmentSize(int seg){
  * @discussion  This function admits the object with request req to the window cache
  *              and removes the least recently used objects from the window until 
  *              the new object fit in the window.
- * @param       req    The index of asegment in the main cache.
- * @result      List of pointers to the objects that have been removed from the window.
+ * @param       req        The request of an object.
+ * @param       victims    Set to the objects that have been removed from the window,
+ *                         a buffer of the caller that keeps its capacity between calls.
 */
-std::list<SimpleRequest*> LRU::admit_with_return(SimpleRequest* req) {
+void LRU::admit_with_return(SimpleRequest* req, std::vector<SimpleRequest>& victims) {
     const uint64_t size = req->getSize();
+    victims.clear();
     // object feasible to store?
-    std::list<SimpleRequest*> victim_list;
     if (size > _cacheSize) {
         LOG("L", _cacheSize, req->getId(), size);
         std::cout << "Size error , req " << req->getId() << " size / cache size " << req->getSize() << " " << _cacheSize <<std::endl;
-        return victim_list;
+        return;
     }
     // check eviction needed
+    SimpleRequest victim;
     while (_currentSize + size > _cacheSize) {
-        SimpleRequest* r=evict_return();
-        if(r!=NULL)
-        victim_list.push_back(r);
+        if(evict_return(victim))
+        victims.push_back(victim);
     }
     // admit new object
     admit(req);
-    return victim_list;
 }
 
 
@@ -1032,48 +1095,73 @@ void W_TinyLFU::admit(SimpleRequest* req)
    // std::cout << "Admitting object  " << obj.id <<std::endl;
    if(window.getSize()==0) {
         main_cache.admit_from_window(req);
+        _currentSize=main_cache.getCurrentSize();
         return;
    }
-    std::list<SimpleRequest*> req_list = window.admit_with_return(req);
+    window.admit_with_return(req, window_victims);
    // main_cache.update_tiny_lfu(req->getId()); // this causes some drops in some tests
-    if(req_list.size()==0) {
+    if(window_victims.size()==0) {
         //std::cout << " object  " << obj.id << " admitted to window cache " << std::endl;
+        _currentSize=window.getCurrentSize()+main_cache.getCurrentSize();
         return;
     }
     // if we have a victim , try to admit it to SLRU
     // std::cout << "Evicting items from window to SLRU" << std::endl; 
-    for(auto it = req_list.begin();it != req_list.end() ; it++) {
-        CacheObject object(*it);
-        //std::cout << " object  " << object.id << " admiting to main cache " << std::endl;
-        main_cache.admit_from_window(*it);
+    for(auto it = window_victims.begin();it != window_victims.end() ; it++) {
+        //std::cout << " object  " << it->getId() << " admiting to main cache " << std::endl;
+        main_cache.admit_from_window(&*it);
     }
+    _currentSize=window.getCurrentSize()+main_cache.getCurrentSize();
 }
 /*!
  * @function    setPar.
  * @abstract    Set the size of main cache and window cache and initial the door keeper and CM_sketch.
  * @discussion  This function sets the sizes of window and main caches ,adjust the percentage
  *              of the window cache and the main cache and initial the door keeper and the CM_sketch.
- * @param       parName   The name of the added parameter .
+ * @param       parName   The name of the added parameter: "window", or empty for a bare value.
  * @param       parValue  The value of the added parameter.
+ * @result      false for any other parameter name.
 */
-void W_TinyLFU::setPar(std::string parName, std::string parValue) {
+bool W_TinyLFU::setPar(std::string parName, std::string parValue) {
 
     //std::cerr << "parName  " << parName << " parValue = " << parValue << std::endl;
 
-    // if(parName.compare("window") == 0) {
+    // the window percentage, also as a bare value ("W_TinyLFU 1000 10")
+    if(parName.compare("window") != 0 && !parName.empty()) {
+        return false;
+    }
     window_size_p = std::stoull(parValue);
-    //     assert(n>0);
-    //     std::cout<< " main_C " << main_cache.getSize() << std::endl;
-    //     std::cout<<" window  "  << window.getSize() << std::endl;
-    // } else {
-    //     std::cerr << "unrecognized parameter: " << parName << std::endl;
-    // }
     uint64_t cs =_cacheSize*(1-(double(window_size_p)/100));
 
     //TODO try with full cache size
     main_cache.setSize(cs);
     main_cache.initDoor_initCM(_cacheSize);  //check if coorect
     window.setSize(_cacheSize*(double(window_size_p)/100));
+    return true;
+}
+/*!
+ * @function    setSize.
+ * @abstract    Sets the size of the whole cache.
+ * @discussion  This function splits the size between the window and the main cache
+ *              by the current window percentage, both evict what no longer fits.
+ * @param       cs    The size of the cache = window + main cache.
+*/
+void W_TinyLFU::setSize(uint64_t cs) {
+    _cacheSize = cs;
+    main_cache.setSize(cs*(1-double(window_size_p)/100));
+    window.setSize(cs*double(window_size_p)/100);
+    _currentSize = window.getCurrentSize() + main_cache.getCurrentSize();
+}
+/*!
+ * @function    setTraceInfo.
+ * @abstract    Passes the trace properties on to the window and the main cache.
+ * @param       objects    The number of distinct objects in the trace.
+ * @param       denseIds   true if the ids are in [0, objects).
+*/
+void W_TinyLFU::setTraceInfo(uint64_t objects, bool denseIds) {
+    Cache::setTraceInfo(objects, denseIds);
+    window.setTraceInfo(objects, denseIds);
+    main_cache.setTraceInfo(objects, denseIds);
 }
 /*!
  * @function    hillClimber.
@@ -1135,17 +1223,20 @@ void W_TinyLFU::hillClimber(int reqs,int hits){
  * @discussion  This function moves objects from main cache to the window cache.
 */
 void W_TinyLFU::increaseWindow() {
-    SimpleRequest* req;
+    SimpleRequest req;
     while ( getSize()*(1-double(window_size_p)/100) < main_cache.getCurrentSize()) {
         // check if the first segment is empty or not
+        bool evicted;
         if(main_cache.getCurrentSegmentSize(0) <= 0){
                 // if empty move an object from the second segment to the window cache
-                req =  main_cache.evict_return(1);
+                evicted = main_cache.evict_return(1, req);
         } else{
                 // if not empty move an object from the first segment to the window cache
-                req =  main_cache.evict_return(0);
+                evicted = main_cache.evict_return(0, req);
         }
-        window.admit(req);
+        if(!evicted)
+            break;
+        window.admit(&req);
     }
     // caclculate the size of the main cache after moving all the objects that had to be moved
     main_cache.setSize(_cacheSize*(1-double(window_size_p)/100));
@@ -1156,29 +1247,59 @@ void W_TinyLFU::increaseWindow() {
  * @discussion  This function moves objects from window cache to the main cache.
 */
 void W_TinyLFU::increaseMainCache() {
-    SimpleRequest* req; 
+    SimpleRequest req; 
     while ( getSize()*(double(window_size_p)/100) < window.getCurrentSize()) {
         // eveict an object from window cache
-        req =  window.evict_return();
+        if(!window.evict_return(req))
+            break;
         // check if the first segment is full
         if(main_cache.getCurrentSegmentSize(0)>=main_cache.getSegmentSize(0)){
             // if full then admit the victim of the window to the secnod segment
-                main_cache.segment_admit(1,req);
+                main_cache.segment_admit(1,&req);
         } else{
             // if not full then admit the victim of the window to the first segment           
-                main_cache.segment_admit(0,req);
+                main_cache.segment_admit(0,&req);
         }
     }
     // calculate the size of the window after removing all the objects that had to be removed
     window.setSize(_cacheSize*double(window_size_p)/100);
 }
 
-void W_TinyLFU::evict(SimpleRequest* req) {}
-void W_TinyLFU::evict() {}
-
-
-
-
-
-
+/*!
+ * @function    evict.
+ * @abstract    Evict the object with request req from the window or the main cache.
+ * @param       req    The request of an object.
+*/
+void W_TinyLFU::evict(SimpleRequest* req) {
+    window.evict(req);
+    main_cache.evict(req);
+    _currentSize = window.getCurrentSize() + main_cache.getCurrentSize();
+}
+/*!
+ * @function    evict.
+ * @abstract    Evict the least recently used object of the window, or of the main cache if the window is empty.
+*/
+void W_TinyLFU::evict() {
+    if(window.getCurrentSize() > 0) {
+        window.evict();
+    } else {
+        main_cache.evict();
+    }
+    _currentSize = window.getCurrentSize() + main_cache.getCurrentSize();
+}
 
+/*
+  replay loops specialized for each policy (see SpecializedCache in cache.h)
+*/
+template class SpecializedCache<LRUCache>;
+template class SpecializedCache<LRUCache32>;
+template class SpecializedCache<FIFOCache>;
+template class SpecializedCache<FIFOCache32>;
+template class SpecializedCache<FilterCache>;
+template class SpecializedCache<ThLRUCache>;
+template class SpecializedCache<ExpLRUCache>;
+template class SpecializedCache<AdaptSizeCache>;
+template class SpecializedCache<S4LRUCache>;
+template class SpecializedCache<TinyLFU>;
+template class SpecializedCache<SLRUCache>;
+template class SpecializedCache<W_TinyLFU>;
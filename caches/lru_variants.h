@@ -1,71 +1,141 @@
 #ifndef LRU_VARIANTS_H
 #define LRU_VARIANTS_H
 
-#include <unordered_map>
 #include <list>
 #include <random>
 #include "cache.h"
 #include "cache_object.h"
+#include "flat_map.h"
+#include "lru_table.h"
 #include "adaptsize_const.h" /* AdaptSize constants */
 #include "caches/sketch/countmin.h"
+// its min and max macros would break standard headers included after this one
+#undef min
+#undef max
+#include "random_helper.h"
 
 
-typedef std::list<CacheObject>::iterator ListIteratorType;
-typedef std::unordered_map<CacheObject, ListIteratorType> lruCacheMapType;
-
 /*
   LRU: Least Recently Used eviction
+
+  Object is the representation of objects in the table: CacheObject, or
+  CacheObject32 for the compact "LRU32" (dense ids and sizes below 4 GiB)
 */
-class LRUCache : public Cache
+template<class Object>
+class BasicLRUCache : public Cache
 {
 protected:
-    // list for recency order
-    // std::list is a container, usually, implemented as a doubly-linked list 
-    std::list<CacheObject> _cacheList;
-    // map to find objects in list
-    lruCacheMapType _cacheMap;
+    typedef BasicLRUTable<Object> Table;
 
-    virtual void hit(lruCacheMapType::const_iterator it, uint64_t size);
+    // objects in recency order, and the table to find them
+    Table _cacheTable;
+
+    virtual void hit(typename Table::Index slot, uint64_t size);
 
 public:
-    LRUCache()
+    BasicLRUCache()
         : Cache()
     {
     }
-    virtual ~LRUCache()
+    virtual ~BasicLRUCache()
     {
     }
 
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
+    virtual unsigned int idBits() const {
+        return 8 * sizeof(typename Object::id_type);
+    }
     virtual bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
-    virtual SimpleRequest* evict_return();
+    // evict the least recently used object into victim, false if the cache is empty
+    virtual bool evict_return(SimpleRequest& victim);
 
+protected:
+    // processBatch below replays this class (see SpecializedCache), subclasses
+    // that override lookup or admit inherit this and get Cache::processBatch
+    typedef BasicLRUCache BatchPolicy;
+
+    // lookup and admit inlined into one loop, a miss inserts into the slots
+    // its lookup just loaded (unless the evictions moved them out of the CPU cache).
+    // The first slot of the request _prefetchDistance ahead is prefetched first.
+    template<class Policy>
+    static void processBatch(Policy& cache, const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        const size_t ahead = cache._prefetchDistance;
+        for (size_t i = 0; i < n; i++) {
+            if (ahead > 0 && i + ahead < n) {
+                cache._cacheTable.prefetch(Object(&reqs[i + ahead]));
+            }
+            const Object obj(&reqs[i]);
+            const typename Table::Index slot = cache._cacheTable.find(obj);
+            if (slot != Table::NIL) {
+                LOG("h", 0, obj.id, obj.size);
+                cache.hit(slot, obj.size);
+                hitFlags[i] = 1;
+                continue;
+            }
+            hitFlags[i] = 0;
+            // object feasible to store?
+            if (obj.size > cache._cacheSize) {
+                LOG("L", cache._cacheSize, obj.id, obj.size);
+                continue;
+            }
+            while (cache._currentSize + obj.size > cache._cacheSize) {
+                cache.evict();
+            }
+            cache._cacheTable.pushFront(obj);
+            cache._currentSize += obj.size;
+            LOG("a", cache._currentSize, obj.id, obj.size);
+        }
+    }
 };
 
-static Factory<LRUCache> factoryLRU("LRU");
+// instantiated in lru_variants.cpp
+extern template class BasicLRUCache<CacheObject>;
+extern template class BasicLRUCache<CacheObject32>;
+typedef BasicLRUCache<CacheObject> LRUCache;
+typedef BasicLRUCache<CacheObject32> LRUCache32;
+
+extern template class SpecializedCache<LRUCache>;
+static SpecializedFactory<LRUCache> factoryLRU("LRU");
+extern template class SpecializedCache<LRUCache32>;
+static SpecializedFactory<LRUCache32> factoryLRU32("LRU32");
 
 
 /*
   FIFO: First-In First-Out eviction
 */
-class FIFOCache : public LRUCache
+template<class Object>
+class BasicFIFOCache : public BasicLRUCache<Object>
 {
 protected:
-    virtual void hit(lruCacheMapType::const_iterator it, uint64_t size);
+    // only hit differs, so BasicLRUCache::processBatch replays FIFO too
+    // and calls hit on the concrete cache
+    typedef BasicFIFOCache BatchPolicy;
+    friend class BasicLRUCache<Object>;
+
+    virtual void hit(typename BasicLRUCache<Object>::Table::Index slot, uint64_t size);
 
 public:
-    FIFOCache()
-        : LRUCache()
+    BasicFIFOCache()
+        : BasicLRUCache<Object>()
     {
     }
-    virtual ~FIFOCache()
+    virtual ~BasicFIFOCache()
     {
     }
 };
 
-static Factory<FIFOCache> factoryFIFO("FIFO");
+extern template class BasicFIFOCache<CacheObject>;
+extern template class BasicFIFOCache<CacheObject32>;
+typedef BasicFIFOCache<CacheObject> FIFOCache;
+typedef BasicFIFOCache<CacheObject32> FIFOCache32;
+
+extern template class SpecializedCache<FIFOCache>;
+static SpecializedFactory<FIFOCache> factoryFIFO("FIFO");
+extern template class SpecializedCache<FIFOCache32>;
+static SpecializedFactory<FIFOCache32> factoryFIFO32("FIFO32");
 
 /*
   FilterCache (admit only after N requests)
@@ -74,7 +144,7 @@ class FilterCache : public LRUCache
 {
 protected:
     uint64_t _nParam;
-    std::unordered_map<CacheObject, uint64_t> _filter;
+    FlatMap<CacheObject, uint64_t> _filter;
 
 public:
     FilterCache();
@@ -82,12 +152,37 @@ public:
     {
     }
 
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool setPar(std::string parName, std::string parValue);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
+
+protected:
+    typedef FilterCache BatchPolicy;
+
+    // the generic loop, with the filter's and the cache's first slots
+    // of the request _prefetchDistance ahead prefetched first
+    template<class Policy>
+    static void processBatch(Policy& cache, const SimpleRequest* reqs, size_t n, uint8_t* hitFlags) {
+        const size_t ahead = cache._prefetchDistance;
+        for (size_t i = 0; i < n; i++) {
+            if (ahead > 0 && i + ahead < n) {
+                const CacheObject next(&reqs[i + ahead]);
+                cache._filter.prefetch(next);
+                cache._cacheTable.prefetch(next);
+            }
+            SimpleRequest* req = const_cast<SimpleRequest*>(&reqs[i]);
+            const bool hit = cache.lookup(req);
+            if (!hit) {
+                cache.admit(req);
+            }
+            hitFlags[i] = hit;
+        }
+    }
 };
 
-static Factory<FilterCache> factoryFilter("Filter");
+extern template class SpecializedCache<FilterCache>;
+static SpecializedFactory<FilterCache> factoryFilter("Filter");
 
 /*
   ThLRU: LRU eviction with a size admission threshold
@@ -103,11 +198,12 @@ public:
     {
     }
 
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool setPar(std::string parName, std::string parValue);
     virtual void admit(SimpleRequest* req);
 };
 
-static Factory<ThLRUCache> factoryThLRU("ThLRU");
+extern template class SpecializedCache<ThLRUCache>;
+static SpecializedFactory<ThLRUCache> factoryThLRU("ThLRU");
 
 /*
   ExpLRU: LRU eviction with size-aware probabilistic cache admission
@@ -116,6 +212,7 @@ class ExpLRUCache : public LRUCache
 {
 protected:
     double _cParam;
+    Xoshiro256 _generator; // admission rolls, param "seed"
 
 public:
     ExpLRUCache();
@@ -123,11 +220,12 @@ public:
     {
     }
 
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool setPar(std::string parName, std::string parValue);
     virtual void admit(SimpleRequest* req);
 };
 
-static Factory<ExpLRUCache> factoryExpLRU("ExpLRU");
+extern template class SpecializedCache<ExpLRUCache>;
+static SpecializedFactory<ExpLRUCache> factoryExpLRU("ExpLRU");
 
 /*
   AdaptSize: ExpLRU with automatic adaption of the _cParam
@@ -140,7 +238,8 @@ public:
     {
     }
 
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool setPar(std::string parName, std::string parValue);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest*);
     virtual void admit(SimpleRequest*);
 
@@ -151,9 +250,8 @@ private:
     uint64_t _reconfiguration_interval;
     uint64_t _nextReconfiguration;
     double _gss_v;  // golden section search book parameters
-    // for random number generation 
-    std::uniform_real_distribution<double> _uniform_real_distribution = 
-        std::uniform_real_distribution<double>(0.0, 1.0); 
+    // for random number generation, param "seed"
+    Xoshiro256 _generator;
 
     struct ObjInfo {
         double requestCount; // requestRate in adaptsize_stub.h
@@ -161,8 +259,9 @@ private:
 
         ObjInfo() : requestCount(0.0), objSize(0) { }
     };
-    std::unordered_map<CacheObject, ObjInfo> _longTermMetadata;
-    std::unordered_map<CacheObject, ObjInfo> _intervalMetadata;
+    typedef FlatMap<CacheObject, ObjInfo> ObjInfoMapType;
+    ObjInfoMapType _longTermMetadata;
+    ObjInfoMapType _intervalMetadata;
 
     void reconfigure();
     double modelHitRate(double c);
@@ -173,7 +272,8 @@ private:
     std::vector<double> _alignedAdmProb;
 };
 
-static Factory<AdaptSizeCache> factoryAdaptSize("AdaptSize");
+extern template class SpecializedCache<AdaptSizeCache>;
+static SpecializedFactory<AdaptSizeCache> factoryAdaptSize("AdaptSize");
 
 /*
   S4LRU
@@ -202,14 +302,20 @@ public:
     }
 
     virtual void setSize(uint64_t cs);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
     virtual void segment_admit(uint8_t idx, SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
+
+protected:
+    // sum of the segment sizes, so warm-up sees the cache fill
+    void updateCurrentSize();
 };
 
-static Factory<S4LRUCache> factoryS4LRU("S4LRU");
+extern template class SpecializedCache<S4LRUCache>;
+static SpecializedFactory<S4LRUCache> factoryS4LRU("S4LRU");
 
 
 
@@ -225,7 +331,7 @@ protected:
     void update_tiny_lfu(long long id);
 
 public:
-    TinyLFU() : LRUCache() {}
+    TinyLFU() : LRUCache(), cm_sketch(NULL) {}
     
     virtual ~TinyLFU()
     {
@@ -233,22 +339,24 @@ public:
     }
 
     virtual void setSize(uint64_t cs) {
-        //std::cout << "CM_Init" << std::endl;
-        cm_sketch = CM_Init(cs/2, 2, 1033096058);
-        _cacheSize = cs;
-  
+        // the sketch is sized once, a resized cache (sampling) keeps its frequencies
+        if (cm_sketch == NULL) {
+            cm_sketch = CM_Init(cs/2, 2, 1033096058);
+        }
+        LRUCache::setSize(cs);
     }
 
     bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
     //virtual void evict(SimpleRequest* req); // maybe we don't need this
     virtual bool evict(int cand_id);
-    virtual SimpleRequest* evict_return(int cand_id);
+    virtual bool evict_return(int cand_id, SimpleRequest& victim);
     //Need to be updated to support TinyLFU algorithm comparison
 };
 
 
-static Factory<TinyLFU> factoryTinyLFU("TinyLFU");
+extern template class SpecializedCache<TinyLFU>;
+static SpecializedFactory<TinyLFU> factoryTinyLFU("TinyLFU");
 
 /*
     SLRU
@@ -276,6 +384,7 @@ public:
     }
 
     virtual void setSize(uint64_t cs);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual bool lookup(SimpleRequest* req);
     virtual void admit(SimpleRequest* req);
     virtual void segment_admit(uint8_t idx, SimpleRequest* req);
@@ -285,13 +394,14 @@ public:
     void update_cm_sketch(long long id);
     void update_door_keeper(long long id) ;
     int search_door_keeper(long long id);
-    SimpleRequest* evict_return(int);
+    bool evict_return(int segment, SimpleRequest& victim);
     int getCurrentSegmentSize(int seg);
     int getSegmentSize(int seg);
     void initDoor_initCM(uint64_t cs);
 };
 
-static Factory<SLRUCache> factorySLRU("SLRU");
+extern template class SpecializedCache<SLRUCache>;
+static SpecializedFactory<SLRUCache> factorySLRU("SLRU");
 
 /*
   W-TinyLFU 
@@ -312,7 +422,7 @@ class LRU : public LRUCache {
     // virtual void evict(SimpleRequest* req) {}
     // virtual void evict() {}
     // virtual SimpleRequest* evict_return() {}
-    std::list<SimpleRequest*> admit_with_return(SimpleRequest* req);
+    void admit_with_return(SimpleRequest* req, std::vector<SimpleRequest>& victims);
 
 };
 
@@ -325,6 +435,7 @@ protected:
     uint64_t window_size_p;     // the percentage of the window of all cache size [0-100]
     uint64_t reqs,hits;         // for the hillClimber algorithm
     double prev_hit_ratio;
+    std::vector<SimpleRequest> window_victims; // reused by every admit
 public:
     W_TinyLFU() : window_size_p(0.01),Cache(),main_cache(),window()
     {
@@ -347,7 +458,9 @@ public:
     virtual void admit(SimpleRequest* req);
     //virtual void evict(SimpleRequest* req); // maybe we don't need this
     //Need to be updated to support TinyLFU algorithm comparison
-    virtual void setPar(std::string parName, std::string parValue);
+    virtual void setSize(uint64_t cs);
+    virtual bool setPar(std::string parName, std::string parValue);
+    virtual void setTraceInfo(uint64_t objects, bool denseIds);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
     void hillClimber(int reqs, int hits );
@@ -355,6 +468,7 @@ public:
     void increaseMainCache();
 };
 
-static Factory<W_TinyLFU> factoryW_TinyLFU("W_TinyLFU");
+extern template class SpecializedCache<W_TinyLFU>;
+static SpecializedFactory<W_TinyLFU> factoryW_TinyLFU("W_TinyLFU");
 
 #endif
@@ -0,0 +1,31 @@
+#include "memory_pool.h"
+
+MemoryPool::MemoryPool()
+    : _next(nullptr),
+      _end(nullptr)
+{
+    for (size_t c = 0; c < POOL_MAX_BLOCK / POOL_ALIGN; c++) {
+        _free[c] = nullptr;
+    }
+}
+
+MemoryPool::~MemoryPool()
+{
+    for (void* chunk : _chunks) {
+        ::operator delete(chunk);
+    }
+}
+
+void* MemoryPool::allocateFromChunk(size_t blockSize)
+{
+    if (_end - _next < static_cast<ptrdiff_t>(blockSize)) {
+        // the rest of the chunk, less than a block, stays unused;
+        // operator new aligns chunks for any type
+        _next = static_cast<char*>(::operator new(POOL_CHUNK_SIZE));
+        _end = _next + POOL_CHUNK_SIZE;
+        _chunks.push_back(_next);
+    }
+    void* block = _next;
+    _next += blockSize;
+    return block;
+}
@@ -0,0 +1,124 @@
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/*
+  MemoryPool: blocks for container nodes, carved from large chunks
+
+  node-based containers allocate and free one node per insert and
+  erase. The pool keeps a free list per block size (multiples of
+  POOL_ALIGN up to POOL_MAX_BLOCK), so these cost a few instructions
+  instead of a malloc call, and the nodes of one cache stay together.
+  Larger requests (hash table bucket arrays) go to operator new. Freed
+  blocks are only reused by the pool: all chunks are released at once
+  when the pool is destroyed, i.e., with its cache at the end of a run.
+*/
+const size_t POOL_ALIGN = 16; // alignment of long double keys
+const size_t POOL_MAX_BLOCK = 512; // a deque buffer
+const size_t POOL_CHUNK_SIZE = 1 << 16;
+
+class MemoryPool
+{
+protected:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* _free[POOL_MAX_BLOCK / POOL_ALIGN];
+    char* _next; // unused part of the current chunk
+    char* _end;
+    std::vector<void*> _chunks;
+
+    // size class of a block of bytes bytes, bytes > 0
+    static size_t sizeClass(size_t bytes) {
+        return (bytes - 1) / POOL_ALIGN;
+    }
+    void* allocateFromChunk(size_t blockSize);
+
+public:
+    MemoryPool();
+    ~MemoryPool();
+    // containers hold pointers to the pool
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    void* allocate(size_t bytes) {
+        if (bytes == 0 || bytes > POOL_MAX_BLOCK) {
+            return ::operator new(bytes);
+        }
+        FreeBlock*& head = _free[sizeClass(bytes)];
+        if (head == nullptr) {
+            return allocateFromChunk((sizeClass(bytes) + 1) * POOL_ALIGN);
+        }
+        FreeBlock* block = head;
+        head = block->next;
+        return block;
+    }
+    void deallocate(void* p, size_t bytes) {
+        if (bytes == 0 || bytes > POOL_MAX_BLOCK) {
+            ::operator delete(p);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        FreeBlock*& head = _free[sizeClass(bytes)];
+        block->next = head;
+        head = block;
+    }
+};
+
+/*
+  PoolAllocator: C++11 allocator that takes memory from a MemoryPool
+
+  without a pool (default constructed) it uses operator new. Rebound
+  copies share the pool, so a container's nodes and bucket arrays come
+  from the pool it was constructed with.
+*/
+template<class T>
+class PoolAllocator
+{
+protected:
+    MemoryPool* _pool;
+
+    template<class U> friend class PoolAllocator;
+
+public:
+    typedef T value_type;
+
+    PoolAllocator(MemoryPool* pool = nullptr)
+        : _pool(pool)
+    {
+    }
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>& other)
+        : _pool(other._pool)
+    {
+    }
+
+    T* allocate(size_t n) {
+        if (_pool == nullptr) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(_pool->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        if (_pool == nullptr) {
+            ::operator delete(p);
+        } else {
+            _pool->deallocate(p, n * sizeof(T));
+        }
+    }
+
+    template<class U>
+    bool operator==(const PoolAllocator<U>& other) const {
+        return _pool == other._pool;
+    }
+    template<class U>
+    bool operator!=(const PoolAllocator<U>& other) const {
+        return _pool != other._pool;
+    }
+};
+
+#endif /* MEMORY_POOL_H */
@@ -0,0 +1,323 @@
+#include <atomic>
+#include <exception>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <map>
+#include <sys/stat.h>
+#include "experiment_runner.h"
+#include "traces/trace_reader.h"
+#include "traces/request_prefetcher.h"
+
+// first line of a results file
+static const char* const RESULTS_HEADER =
+    "trace,cacheType,cacheSize,params,reqs,hits,objectHitRatio,byteHitRatio";
+
+// quote a CSV field if it contains a separator, quote or line break
+static std::string csvField(const std::string& s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos) {
+        return s;
+    }
+    std::string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string ExperimentJob::key() const
+{
+    std::string joined;
+    for (size_t i = 0; i < params.size(); i++) {
+        joined += (i > 0 ? " " : "") + params[i];
+    }
+    return csvField(trace) + "," + csvField(cacheType) + "," + std::to_string(cacheSize) + ","
+        + csvField(joined);
+}
+
+bool readExperiment(const char* path, std::vector<ExperimentJob>& jobs)
+{
+    std::ifstream infile(path);
+    if (!infile) {
+        std::cerr << "cannot open experiment " << path << std::endl;
+        return false;
+    }
+    std::vector<std::string> traces;
+    std::vector<uint64_t> sizes;
+    std::vector<std::vector<std::string>> configs; // cacheType and params
+    std::string line;
+    while (std::getline(infile, line)) {
+        std::istringstream words(line);
+        std::string kind, word;
+        if (!(words >> kind) || kind[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> items;
+        while (words >> word) {
+            items.push_back(word);
+        }
+        if (kind == "trace") {
+            traces.insert(traces.end(), items.begin(), items.end());
+        } else if (kind == "size") {
+            for (const auto& item : items) {
+                sizes.push_back(std::stoull(item));
+            }
+        } else if (kind == "cache" && !items.empty()) {
+            // expand comma-separated param values into one configuration each
+            std::vector<std::vector<std::string>> expanded(1, std::vector<std::string>(1, items[0]));
+            for (size_t p = 1; p < items.size(); p++) {
+                std::vector<std::vector<std::string>> next;
+                // only the value of name=value is a list, each copy keeps the name
+                const size_t eq = items[p].find('=');
+                const std::string name = (eq == std::string::npos) ? "" : items[p].substr(0, eq + 1);
+                std::istringstream values(items[p].substr(name.size()));
+                std::string value;
+                while (std::getline(values, value, ',')) {
+                    for (auto config : expanded) {
+                        config.push_back(name + value);
+                        next.push_back(config);
+                    }
+                }
+                expanded.swap(next);
+            }
+            configs.insert(configs.end(), expanded.begin(), expanded.end());
+        } else {
+            std::cerr << "invalid experiment line: " << line << std::endl;
+            return false;
+        }
+    }
+
+    for (const auto& trace : traces) {
+        struct stat st;
+        const uint64_t cost = stat(trace.c_str(), &st) == 0 ? st.st_size : 0;
+        for (const auto& config : configs) {
+            for (const auto size : sizes) {
+                ExperimentJob job;
+                job.trace = trace;
+                job.cacheType = config[0];
+                job.cacheSize = size;
+                job.params.assign(config.begin() + 1, config.end());
+                job.cost = cost;
+                jobs.push_back(job);
+            }
+        }
+    }
+    return true;
+}
+
+/*
+  WorkStealingPool
+*/
+WorkStealingPool::WorkStealingPool(unsigned int threads)
+{
+    for (unsigned int t = 0; t < std::max(threads, 1u); t++) {
+        _queues.push_back(std::unique_ptr<Queue>(new Queue));
+    }
+}
+
+bool WorkStealingPool::next(size_t t, size_t& task)
+{
+    {
+        Queue& own = *_queues[t];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // tasks are never added while running, so a full round of empty queues ends the thread
+    for (size_t i = 1; i < _queues.size(); i++) {
+        Queue& victim = *_queues[(t + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t tasks, const std::function<void(size_t)>& task)
+{
+    for (size_t i = 0; i < tasks; i++) {
+        _queues[i % _queues.size()]->tasks.push_back(i);
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < _queues.size(); t++) {
+        threads.push_back(std::thread([this, t, &task] {
+            size_t i;
+            while (next(t, i)) {
+                task(i);
+            }
+        }));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/*
+  ExperimentRunner
+*/
+ExperimentRunner::ExperimentRunner(unsigned int threads, const StatsConfig& config,
+                                   CacheCreator createCache, const std::string& resultsPath)
+    : _threads(threads),
+      _config(config),
+      _createCache(createCache),
+      _resultsPath(resultsPath)
+{
+}
+
+bool ExperimentRunner::readResults()
+{
+    std::ifstream infile(_resultsPath);
+    bool endsWithNewline = true;
+    bool empty = true;
+    if (infile) {
+        std::string line;
+        while (std::getline(infile, line)) {
+            endsWithNewline = !infile.eof();
+            // the header has as many separators as a result
+            if (empty && line == RESULTS_HEADER) {
+                empty = false;
+                continue;
+            }
+            empty = false;
+            // the key is the text before the fourth separator outside quotes,
+            // a line cut short by an interrupted run is the last one, without line break
+            size_t separators = 0, keyEnd = 0;
+            bool quoted = false;
+            for (size_t i = 0; i < line.size(); i++) {
+                if (line[i] == '"') {
+                    quoted = !quoted;
+                } else if (line[i] == ',' && !quoted && ++separators == 4) {
+                    keyEnd = i;
+                }
+            }
+            if (separators == 7 && endsWithNewline) {
+                _done.insert(line.substr(0, keyEnd));
+            }
+        }
+    }
+    _results.open(_resultsPath, std::ios::app);
+    if (!_results) {
+        std::cerr << "cannot open results file " << _resultsPath << std::endl;
+        return false;
+    }
+    if (empty) {
+        _results << RESULTS_HEADER << std::endl;
+    } else if (!endsWithNewline) {
+        _results << std::endl;
+    }
+    return true;
+}
+
+size_t ExperimentRunner::runGroup(const std::vector<const ExperimentJob*>& jobs)
+{
+    // the pool's threads are busy, so one thread simulates all caches of the group
+    CacheSweep sweep(1, _config);
+    std::vector<const ExperimentJob*> added;
+    size_t failed = 0;
+    for (const ExperimentJob* job : jobs) {
+        std::unique_ptr<Cache> cache = _createCache(*job);
+        if (cache == nullptr || !cache->checkTraceIds(job->cacheType)) {
+            std::cerr << "job failed: " << job->key() << std::endl;
+            failed++;
+            continue;
+        }
+        sweep.add(job->key(), std::move(cache), job->cacheSize);
+        added.push_back(job);
+    }
+    if (added.empty()) {
+        return failed;
+    }
+
+    bool read = false;
+    std::unique_ptr<TraceReader> trace = TraceReader::create_unique(added[0]->trace, 1);
+    if (trace != nullptr) {
+        trace->setDecodeTimes(_config.intervalTime > 0);
+        // decoded on a thread of its own, a sweep holds up to SWEEP_WINDOW batches itself
+        RequestPrefetcher prefetcher(std::move(trace), PREFETCH_RING_SIZE + SWEEP_WINDOW);
+        read = sweep.run(prefetcher);
+    }
+
+    std::lock_guard<std::mutex> lock(_resultsMutex);
+    for (size_t i = 0; i < added.size(); i++) {
+        if (!read || !sweep.error(i).empty()) {
+            if (read) {
+                std::cerr << added[i]->key() << ": " << sweep.error(i) << std::endl;
+            }
+            std::cerr << "job failed: " << added[i]->key() << std::endl;
+            failed++;
+            continue;
+        }
+        const HitCounters total = sweep.stats(i).total();
+        _results << added[i]->key() << "," << total.reqs << "," << total.hits << ","
+                 << total.objectHitRatio() << "," << total.byteHitRatio() << std::endl;
+        if (!_results) {
+            std::cerr << "cannot write results file " << _resultsPath << std::endl;
+            failed++;
+        }
+    }
+    return failed;
+}
+
+bool ExperimentRunner::run(std::vector<ExperimentJob> jobs)
+{
+    if (!readResults()) {
+        return false;
+    }
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [this](const ExperimentJob& job) {
+        return _done.count(job.key()) > 0;
+    }), jobs.end());
+    std::cerr << jobs.size() << " jobs to run, " << _done.size() << " done before" << std::endl;
+    // the jobs of a trace share one pass over it, in groups of at most an
+    // even share of the jobs per thread
+    const size_t threads = std::max(_threads, 1u);
+    const size_t groupSize = std::max<size_t>(1, (jobs.size() + threads - 1) / threads);
+    std::vector<std::vector<const ExperimentJob*>> groups;
+    std::vector<uint64_t> cost;
+    std::map<std::string, size_t> filling; // trace -> its group that is being filled
+    for (const auto& job : jobs) {
+        auto it = filling.find(job.trace);
+        if (it == filling.end() || groups[it->second].size() == groupSize) {
+            filling[job.trace] = groups.size();
+            groups.emplace_back();
+            cost.push_back(0);
+        }
+        const size_t g = filling[job.trace];
+        groups[g].push_back(&job);
+        cost[g] += job.cost;
+    }
+    // dealing the largest groups first spreads them over all threads
+    std::vector<size_t> order(groups.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&cost](size_t a, size_t b) {
+        return cost[a] > cost[b];
+    });
+
+    std::atomic<size_t> failed(0);
+    WorkStealingPool pool(_threads);
+    pool.run(groups.size(), [&](size_t i) {
+        const std::vector<const ExperimentJob*>& group = groups[order[i]];
+        try {
+            failed += runGroup(group);
+        } catch (const std::exception& e) {
+            // e.g. no memory left for a cache, the other groups go on
+            for (const ExperimentJob* job : group) {
+                std::cerr << job->key() << ": " << e.what() << std::endl;
+                std::cerr << "job failed: " << job->key() << std::endl;
+            }
+            failed += group.size();
+        }
+    });
+    return failed == 0;
+}
@@ -0,0 +1,116 @@
+#ifndef EXPERIMENT_RUNNER_H
+#define EXPERIMENT_RUNNER_H
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "cache.h"
+#include "cache_sweep.h"
+#include "replay_stats.h"
+
+/*
+  ExperimentJob: one trace replayed on one cache configuration
+*/
+struct ExperimentJob
+{
+    std::string trace;
+    std::string cacheType;
+    uint64_t cacheSize;
+    std::vector<std::string> params;
+    uint64_t cost; // estimated run time (trace bytes), larger jobs are started first
+
+    // identifies the job in the results file
+    std::string key() const;
+};
+
+/*
+  readExperiment: expands an experiment file into jobs
+
+  the file lists traces, cache sizes and caches, one item per word:
+
+    trace test.tr multi1.trace
+    size 1000 100000
+    cache LRU
+    cache W_TinyLFU 1,10,20
+
+  Every cache line is one cacheType with its cacheParams, a param with
+  comma-separated values (name=1,2 or a bare 1,2) expands into one
+  configuration per value. The jobs are all combinations of traces, sizes
+  and configurations.
+*/
+bool readExperiment(const char* path, std::vector<ExperimentJob>& jobs);
+
+/*
+  WorkStealingPool: runs numbered tasks on a fixed set of threads
+
+  tasks are dealt round-robin to per-thread queues in the given order,
+  so every thread gets a mix of long and short tasks. A thread takes
+  tasks from the front of its own queue; an idle thread steals from the
+  back of another thread's queue.
+*/
+class WorkStealingPool
+{
+protected:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+
+    // next task for thread t, false if all queues are empty
+    bool next(size_t t, size_t& task);
+
+public:
+    WorkStealingPool(unsigned int threads);
+
+    // run task(0) .. task(tasks-1), returns when all are done
+    void run(size_t tasks, const std::function<void(size_t)>& task);
+};
+
+/*
+  ExperimentRunner: runs experiment jobs and appends their results to a CSV file
+
+  one line "trace,cacheType,cacheSize,params,reqs,hits,objectHitRatio,byteHitRatio"
+  is written and flushed per job. Jobs whose key is already in the file
+  are skipped, so an interrupted run can be resumed.
+  The jobs of a trace are replayed together in one pass over the trace
+  (a CacheSweep), and the pool runs these groups. A trace with more jobs
+  than an even share of the threads is split into several groups, so a
+  few traces still keep all threads simulating.
+*/
+class ExperimentRunner
+{
+public:
+    typedef std::function<std::unique_ptr<Cache>(const ExperimentJob&)> CacheCreator;
+
+protected:
+    unsigned int _threads;
+    StatsConfig _config;
+    CacheCreator _createCache;
+    std::string _resultsPath;
+    std::set<std::string> _done; // keys of the jobs in the results file
+    std::ofstream _results;
+    std::mutex _resultsMutex;
+
+    // read the keys of finished jobs
+    bool readResults();
+    // replay the jobs, all of the same trace, in one pass, returns the
+    // number of jobs that failed
+    size_t runGroup(const std::vector<const ExperimentJob*>& jobs);
+
+public:
+    ExperimentRunner(unsigned int threads, const StatsConfig& config, CacheCreator createCache,
+                     const std::string& resultsPath);
+
+    // run all jobs not in the results file, false if any job failed
+    bool run(std::vector<ExperimentJob> jobs);
+};
+
+#endif /* EXPERIMENT_RUNNER_H */
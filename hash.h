@@ -0,0 +1,34 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <cstring>
+
+// 64-bit finalizer (splitmix64)
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// 64-bit hash of a byte string, continues from seed to hash concatenations
+inline uint64_t hashBytes(const char* p, size_t len, uint64_t seed = 0)
+{
+    uint64_t h = seed ^ 0x9e3779b97f4a7c15ull;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = mix64(h ^ word);
+        p += 8;
+        len -= 8;
+    }
+    uint64_t word = 0;
+    memcpy(&word, p, len);
+    return mix64(h ^ word ^ (uint64_t(len) << 56));
+}
+
+#endif /* HASH_H */
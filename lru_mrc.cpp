@@ -0,0 +1,134 @@
+#include <algorithm>
+#include "lru_mrc.h"
+
+// slots in the Fenwick tree at least, it grows with the number of objects
+const uint64_t MRC_MIN_SLOTS = 1 << 16;
+// bins of 64-bit stack distances
+const size_t MRC_BINS = 64 * MRC_BINS_PER_DOUBLING;
+// size of an unused slot
+const uint64_t FREE_SLOT = UINT64_MAX;
+
+LRUMissRatioCurve::LRUMissRatioCurve()
+    : _tree(MRC_MIN_SLOTS + 1, 0),
+      _slotId(MRC_MIN_SLOTS),
+      _slotSize(MRC_MIN_SLOTS, FREE_SLOT),
+      _nextSlot(0),
+      _stackBytes(0),
+      _binReqs(MRC_BINS, 0),
+      _binBytes(MRC_BINS, 0),
+      _binMax(MRC_BINS, 0),
+      _reqs(0),
+      _bytes(0)
+{
+}
+
+void LRUMissRatioCurve::add(uint64_t slot, int64_t size)
+{
+    for (uint64_t i = slot + 1; i < _tree.size(); i += i & (~i + 1)) {
+        _tree[i] += size;
+    }
+}
+
+uint64_t LRUMissRatioCurve::prefix(uint64_t slot) const
+{
+    uint64_t sum = 0;
+    for (uint64_t i = slot + 1; i > 0; i -= i & (~i + 1)) {
+        sum += _tree[i];
+    }
+    return sum;
+}
+
+size_t LRUMissRatioCurve::bin(uint64_t distance)
+{
+    if (distance == 0) {
+        return 0;
+    }
+    // power of two, then MRC_BINS_PER_DOUBLING linear steps within it
+    const unsigned int e = 63 - __builtin_clzll(distance);
+    const unsigned int shift = __builtin_ctz(MRC_BINS_PER_DOUBLING);
+    const uint64_t step = (e >= shift) ? (distance >> (e - shift)) : (distance << (shift - e));
+    return e * MRC_BINS_PER_DOUBLING + (step & (MRC_BINS_PER_DOUBLING - 1));
+}
+
+void LRUMissRatioCurve::compact()
+{
+    // twice the live objects leaves room for as many requests before the next compaction
+    const uint64_t slots = std::max<uint64_t>(MRC_MIN_SLOTS, 2 * _lastSlot.size());
+    std::vector<IdType> slotId(slots);
+    std::vector<uint64_t> slotSize(slots, FREE_SLOT);
+    uint64_t next = 0;
+    for (uint64_t s = 0; s < _nextSlot; s++) {
+        if (_slotSize[s] == FREE_SLOT) {
+            continue;
+        }
+        SimpleRequest req(_slotId[s], _slotSize[s]);
+        _lastSlot[CacheObject(&req)] = next;
+        slotId[next] = _slotId[s];
+        slotSize[next] = _slotSize[s];
+        next++;
+    }
+    _slotId.swap(slotId);
+    _slotSize.swap(slotSize);
+    _nextSlot = next;
+
+    // build the tree in linear time
+    _tree.assign(slots + 1, 0);
+    for (uint64_t i = 1; i <= slots; i++) {
+        if (i <= next) {
+            _tree[i] += _slotSize[i - 1];
+        }
+        const uint64_t parent = i + (i & (~i + 1));
+        if (parent <= slots) {
+            _tree[parent] += _tree[i];
+        }
+    }
+}
+
+void LRUMissRatioCurve::request(SimpleRequest* req)
+{
+    const uint64_t size = req->getSize();
+    _reqs++;
+    _bytes += size;
+
+    if (_nextSlot == _slotSize.size()) {
+        compact();
+    }
+    CacheObject obj(req);
+    auto it = _lastSlot.find(obj);
+    if (it != _lastSlot.end()) {
+        // bytes requested after the previous request of this object, plus its own size
+        const uint64_t last = it->second;
+        const uint64_t distance = _stackBytes - prefix(last) + size;
+        const size_t b = bin(distance);
+        _binReqs[b]++;
+        _binBytes[b] += size;
+        _binMax[b] = std::max<uint64_t>(_binMax[b], distance);
+        // move the object to the top of the stack
+        add(last, -int64_t(size));
+        _slotSize[last] = FREE_SLOT;
+        it->second = _nextSlot;
+    } else {
+        // first request, a miss at every cache size
+        _lastSlot.emplace(obj, _nextSlot);
+        _stackBytes += size;
+    }
+    add(_nextSlot, size);
+    _slotId[_nextSlot] = obj.id;
+    _slotSize[_nextSlot] = size;
+    _nextSlot++;
+}
+
+void LRUMissRatioCurve::print(std::ostream& out, double sampleRate) const
+{
+    // a cache of _binMax[b] bytes holds the stack distances of all bins up to b
+    uint64_t hits = 0, hitBytes = 0;
+    for (size_t b = 0; b < MRC_BINS; b++) {
+        if (_binReqs[b] == 0) {
+            continue;
+        }
+        hits += _binReqs[b];
+        hitBytes += _binBytes[b];
+        out << uint64_t(_binMax[b] / sampleRate) << " " << double(_reqs - hits) / _reqs << " "
+            << double(_bytes - hitBytes) / _bytes << std::endl;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef LRU_MRC_H
+#define LRU_MRC_H
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "caches/cache_object.h"
+#include "caches/flat_map.h"
+
+// log-spaced histogram bins per power of two of the stack distance
+const unsigned int MRC_BINS_PER_DOUBLING = 64;
+
+/*
+  LRUMissRatioCurve: LRU miss ratios for all cache sizes in one pass
+
+  a request hits in an LRU cache of C bytes iff its stack distance (the
+  bytes of all distinct objects requested since its previous request,
+  plus its own size) is at most C. Stack distances come from a Fenwick
+  tree over the slot of every object's last request, weighted by the
+  object's size, in O(log n) per request. Slots are compacted when the
+  tree is full, so memory is proportional to the number of objects.
+
+  The curve is exact for cache sizes at least as large as the largest
+  object: LRUCache does not admit larger objects, here they still occupy
+  stack space.
+*/
+class LRUMissRatioCurve
+{
+protected:
+    FlatMap<CacheObject, uint64_t> _lastSlot; // slot of each object's last request
+    std::vector<uint64_t> _tree; // Fenwick tree of object sizes by slot (1-based)
+    std::vector<IdType> _slotId; // object in each slot
+    std::vector<uint64_t> _slotSize; // object size in each slot, FREE_SLOT if unused
+    uint64_t _nextSlot;
+    uint64_t _stackBytes; // sum of sizes of all objects on the stack
+
+    // histogram of stack distances: requests, bytes and the largest distance per bin
+    std::vector<uint64_t> _binReqs;
+    std::vector<uint64_t> _binBytes;
+    std::vector<uint64_t> _binMax;
+    uint64_t _reqs;
+    uint64_t _bytes;
+
+    void add(uint64_t slot, int64_t size);
+    // sum of sizes in slots 0..slot
+    uint64_t prefix(uint64_t slot) const;
+    // renumber the objects' slots in order of their last request
+    void compact();
+    static size_t bin(uint64_t distance);
+
+public:
+    LRUMissRatioCurve();
+
+    void request(SimpleRequest* req);
+
+    // print "cacheSize objectMissRatio byteMissRatio" for every distinct point of the curve,
+    // cache sizes are scaled up by the sampling rate of a sampled trace
+    void print(std::ostream& out, double sampleRate = 1.0) const;
+};
+
+#endif /* LRU_MRC_H */
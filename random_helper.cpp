@@ -1,9 +1,10 @@
-#include <random>
 #include "random_helper.h"
+#include "hash.h"
 
-std::mt19937_64 globalGenerator;
-
-void seedGenerator()
+void Xoshiro256::seed(uint64_t seed)
 {
-    globalGenerator.seed(SEED);
+    // expand the seed with splitmix64, which never yields an all-zero state
+    for (int i = 0; i < 4; i++) {
+        _s[i] = mix64(seed += 0x9e3779b97f4a7c15ULL);
+    }
 }
@@ -1,11 +1,63 @@
 #ifndef RANDOM_HELPER_H
 #define RANDOM_HELPER_H
 
-#include <random>
+#include <cmath>
+#include <cstdint>
 
 const unsigned int SEED = 1534262824; // const seed for repeatable results
-extern std::mt19937_64 globalGenerator;
 
-void seedGenerator();
+/*
+  Xoshiro256: xoshiro256** pseudo-random generator
+
+  small and fast, so every randomized cache owns one: results do not
+  depend on other caches simulated in the same process or thread.
+  Models UniformRandomBitGenerator for use with <random> distributions
+  (min and max are parenthesized against the min/max macros of countmin.h).
+*/
+class Xoshiro256
+{
+protected:
+    uint64_t _s[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed = SEED) {
+        this->seed(seed);
+    }
+
+    void seed(uint64_t seed);
+
+    static constexpr result_type (min)() {
+        return 0;
+    }
+    static constexpr result_type (max)() {
+        return UINT64_MAX;
+    }
+    result_type operator()() {
+        const uint64_t result = rotl(_s[1] * 5, 7) * 9;
+        const uint64_t t = _s[1] << 17;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = rotl(_s[3], 45);
+        return result;
+    }
+};
+
+// probability p as a threshold on generator outputs: gen() < threshold with probability p
+inline uint64_t probabilityThreshold(double p)
+{
+    if (p >= 1.0) {
+        return UINT64_MAX;
+    }
+    return p > 0.0 ? uint64_t(std::ldexp(p, 64)) : 0;
+}
 
 #endif /* RANDOM_HELPER_H */
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include "replay_stats.h"
+
+// intervals preallocated before the replay, more are added in doubling steps
+const size_t STATS_INITIAL_INTERVALS = 1024;
+
+ReplayStats::ReplayStats(const StatsConfig& config)
+    : _config(config),
+      _warm(!config.warmupFill && config.warmupRequests == 0),
+      _replayed(0),
+      _counted(0),
+      _boundary(0),
+      _hitFlags(TRACE_BATCH_SIZE)
+{
+    if (_config.intervals()) {
+        _intervals.reserve(STATS_INITIAL_INTERVALS);
+    } else {
+        // a single interval without end
+        _intervals.push_back(Interval(0));
+        _boundary = UINT64_MAX;
+    }
+}
+
+void ReplayStats::nextInterval(uint64_t pos)
+{
+    const uint64_t step = _config.intervalTime > 0 ? _config.intervalTime : _config.intervalRequests;
+    // the first interval starts at the first counted request
+    uint64_t start = pos;
+    if (!_intervals.empty()) {
+        start = _boundary + (pos - _boundary) / step * step;
+    }
+    _intervals.push_back(Interval(start));
+    _boundary = start + step;
+}
+
+void ReplayStats::count(const RequestBatch* batch, size_t first)
+{
+    const bool byTime = _config.intervalTime > 0;
+    const uint8_t* flags = _hitFlags.data();
+    HitCounters* interval = _intervals.empty() ? nullptr : &_intervals.back().counters;
+    for (size_t i = first; i < batch->size; i++) {
+        const uint64_t pos = byTime ? batch->times[i] : _counted;
+        if (pos >= _boundary) {
+            nextInterval(pos);
+            interval = &_intervals.back().counters;
+        }
+        const uint64_t size = batch->reqs[i].getSize();
+        const uint64_t hit = flags[i];
+        interval->add(size, hit);
+        // floor(log2(size)), without a branch for size 0
+        _sizeClasses[63 - __builtin_clzll(size | 1)].add(size, hit);
+        _counted++;
+        if (_config.sampled) {
+            _error.add(batch->reqs[i].getId(), hit);
+        }
+    }
+}
+
+void ReplayStats::replay(Cache* cache, RequestBatch* batch)
+{
+    const size_t n = batch->size;
+    if (_hitFlags.size() < n) {
+        _hitFlags.resize(n);
+    }
+    SimpleRequest* reqs = batch->reqs.data();
+    uint8_t* flags = _hitFlags.data();
+    size_t first = 0;
+    if (!_warm && _config.warmupFill) {
+        // one request at a time until an object does not fit into the free space
+        while (first < n && cache->getCurrentSize() + reqs[first].getSize() <= cache->getSize()) {
+            cache->process_batch(&reqs[first], 1, &flags[first]);
+            first++;
+        }
+        _warm = first < n;
+        cache->process_batch(&reqs[first], n - first, &flags[first]);
+    } else {
+        cache->process_batch(reqs, n, flags);
+        if (!_warm) {
+            first = std::min<uint64_t>(n, _config.warmupRequests - _replayed);
+            _warm = _replayed + first == _config.warmupRequests;
+        }
+    }
+    _replayed += n;
+    count(batch, first);
+}
+
+HitCounters ReplayStats::total() const
+{
+    HitCounters total;
+    for (size_t c = 0; c < STATS_SIZE_CLASSES; c++) {
+        total.add(_sizeClasses[c]);
+    }
+    return total;
+}
+
+void ReplayStats::printIntervals(std::ostream& out, const std::string& name) const
+{
+    if (!_config.intervals()) {
+        return;
+    }
+    for (const auto& interval : _intervals) {
+        const HitCounters& counters = interval.counters;
+        out << "interval " << name << " " << interval.start << " "
+            << counters.reqs << " " << counters.hits << " "
+            << counters.objectHitRatio() << " " << counters.byteHitRatio() << std::endl;
+    }
+}
+
+void ReplayStats::printSizeClasses(std::ostream& out, const std::string& name) const
+{
+    if (!_config.sizeClasses) {
+        return;
+    }
+    for (size_t c = 0; c < STATS_SIZE_CLASSES; c++) {
+        const HitCounters& counters = _sizeClasses[c];
+        if (counters.reqs == 0) {
+            continue;
+        }
+        out << "sizeclass " << name << " " << (uint64_t(1) << c) << " "
+            << counters.reqs << " " << counters.hits << " "
+            << counters.bytes << " " << counters.hitBytes << " "
+            << counters.objectHitRatio() << " " << counters.byteHitRatio() << std::endl;
+    }
+}
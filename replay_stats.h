@@ -0,0 +1,145 @@
+#ifndef REPLAY_STATS_H
+#define REPLAY_STATS_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "traces/request_prefetcher.h"
+#include "traces/sampled_trace.h"
+#include "cache.h"
+
+// size classes of objects: class c holds sizes in [2^c, 2^(c+1)), class 0 also size 0
+const size_t STATS_SIZE_CLASSES = 64;
+
+/*
+  HitCounters: requests and hits, counted in objects and in bytes
+*/
+struct HitCounters
+{
+    uint64_t reqs;
+    uint64_t hits;
+    uint64_t bytes;
+    uint64_t hitBytes;
+
+    HitCounters()
+        : reqs(0),
+          hits(0),
+          bytes(0),
+          hitBytes(0)
+    {
+    }
+
+    // hit is 0 or 1
+    void add(uint64_t size, uint64_t hit) {
+        reqs++;
+        hits += hit;
+        bytes += size;
+        hitBytes += hit * size;
+    }
+    void add(const HitCounters& other) {
+        reqs += other.reqs;
+        hits += other.hits;
+        bytes += other.bytes;
+        hitBytes += other.hitBytes;
+    }
+    double objectHitRatio() const {
+        return double(hits) / reqs;
+    }
+    double byteHitRatio() const {
+        return double(hitBytes) / bytes;
+    }
+};
+
+/*
+  StatsConfig: what a replay counts
+
+  the warm-up is a number of requests, or lasts until the first request
+  whose object does not fit into the cache's free space (the cache is
+  full). Intervals are measured in counted requests or in trace time.
+*/
+struct StatsConfig
+{
+    uint64_t warmupRequests;
+    bool warmupFill;
+    uint64_t intervalRequests; // 0 for no intervals
+    uint64_t intervalTime; // 0 for no intervals
+    bool sampled; // estimate the sampling error (see SampleError)
+    bool sizeClasses; // print the counters per size class
+
+    StatsConfig()
+        : warmupRequests(0),
+          warmupFill(false),
+          intervalRequests(0),
+          intervalTime(0),
+          sampled(false),
+          sizeClasses(false)
+    {
+    }
+
+    bool intervals() const {
+        return intervalRequests > 0 || intervalTime > 0;
+    }
+};
+
+/*
+  ReplayStats: replays batches on a cache and counts hits after the warm-up
+
+  requests, hits and bytes are counted per interval (one interval for
+  the whole replay without intervals) and per log2 size class in
+  preallocated counters, from the hit flags of Cache::process_batch. Intervals
+  without requests are not recorded.
+*/
+class ReplayStats
+{
+protected:
+    struct Interval {
+        uint64_t start; // number of the first request, or its time
+        HitCounters counters;
+
+        Interval(uint64_t start)
+            : start(start)
+        {
+        }
+    };
+
+    StatsConfig _config;
+    bool _warm; // the warm-up is over
+    uint64_t _replayed; // requests replayed, including the warm-up
+    uint64_t _counted; // requests counted
+    uint64_t _boundary; // position at which the current interval ends
+    std::vector<Interval> _intervals;
+    HitCounters _sizeClasses[STATS_SIZE_CLASSES];
+    std::vector<uint8_t> _hitFlags;
+    SampleError _error;
+
+    // start the interval that contains position pos
+    void nextInterval(uint64_t pos);
+    // count requests [first, batch->size)
+    void count(const RequestBatch* batch, size_t first);
+
+public:
+    ReplayStats(const StatsConfig& config);
+
+    // simulate a batch on cache and count it
+    void replay(Cache* cache, RequestBatch* batch);
+
+    // false if the replay ended during the warm-up (nothing was counted)
+    bool warm() const {
+        return _warm;
+    }
+    // counters of all counted requests
+    HitCounters total() const;
+    // standard error of the hit ratio of a sampled trace
+    double sampleError() const {
+        return _error.stdError();
+    }
+
+    // one "interval name start reqs hits objectHitRatio byteHitRatio" line per interval
+    void printIntervals(std::ostream& out, const std::string& name) const;
+    // one "sizeclass name minSize reqs hits bytes hitBytes objectHitRatio byteHitRatio"
+    // line per size class with requests
+    void printSizeClasses(std::ostream& out, const std::string& name) const;
+};
+
+#endif /* REPLAY_STATS_H */
@@ -0,0 +1,205 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include "caches/flat_map.h"
+#include "hash.h"
+
+/*
+  randomized differential test of FlatMap against std::unordered_map
+
+  random inserts, operator[] updates, erases by key and by iterator and
+  lookups on a small key space, so erased slots are reused, and the
+  table grows through several rehashes
+*/
+
+// maps every key to one of a few values, so probes run through full
+// groups and compare keys with equal control bytes
+struct CollidingHash {
+    size_t operator()(uint64_t key) const {
+        return mix64(key % 8);
+    }
+};
+
+// the key is the hash: its low bits pick the first group, so a test can
+// fill chosen groups
+struct IdentityHash {
+    size_t operator()(uint64_t key) const {
+        return key;
+    }
+};
+
+template<class Hash>
+class CheckedFlatMap : public FlatMap<uint64_t, uint64_t, Hash>
+{
+public:
+    size_t capacity() const {
+        return this->_capacity;
+    }
+    size_t growthLeft() const {
+        return this->_growthLeft;
+    }
+};
+
+typedef std::unordered_map<uint64_t, uint64_t> Model;
+
+static bool failed(const char* what, uint64_t op)
+{
+    std::cerr << "check failed: FlatMap " << what << " at operation " << op << std::endl;
+    return false;
+}
+
+template<class Map>
+static bool sameEntries(const Map& map, const Model& model, uint64_t op)
+{
+    size_t entries = 0;
+    for (const auto& entry : map) {
+        const auto it = model.find(entry.first);
+        if (it == model.end() || it->second != entry.second) {
+            return failed("iteration", op);
+        }
+        entries++;
+    }
+    if (entries != model.size() || map.size() != model.size()) {
+        return failed("size", op);
+    }
+    return true;
+}
+
+// run ops random operations on keys in [0, keys) on both maps, false if they
+// differ or the map grows beyond maxCapacity
+template<class Hash>
+static bool compare(const char* name, CheckedFlatMap<Hash>& map, Model& model, uint64_t keys,
+                    uint64_t ops, size_t maxCapacity, uint64_t seed)
+{
+    std::mt19937_64 rnd(seed);
+    uint64_t grown = 0;
+    for (uint64_t op = 0; op < ops; op++) {
+        const uint64_t key = rnd() % keys;
+        const size_t capacity = map.capacity();
+        switch (rnd() % 6) {
+        case 0: {
+            const auto result = map.emplace(key, op);
+            const bool inserted = model.emplace(key, op).second;
+            if (result.second != inserted || result.first->first != key
+                || result.first->second != model[key]) {
+                return failed("emplace", op);
+            }
+            break;
+        }
+        case 1:
+            map[key] += op;
+            model[key] += op;
+            break;
+        case 2:
+        case 3:
+            if (map.erase(key) != model.erase(key)) {
+                return failed("erase(key)", op);
+            }
+            break;
+        case 4: {
+            const auto it = map.find(key);
+            if ((it == map.end()) != (model.count(key) == 0)) {
+                return failed("find", op);
+            }
+            if (it != map.end()) {
+                map.erase(it);
+                model.erase(key);
+            }
+            break;
+        }
+        default:
+            if (map.count(key) != model.count(key)
+                || (model.count(key) > 0 && map.find(key)->second != model[key])) {
+                return failed("count", op);
+            }
+        }
+        grown += map.capacity() > capacity;
+        if (map.size() != model.size()) {
+            return failed("size", op);
+        }
+        if (map.capacity() > maxCapacity) {
+            return failed("capacity", op);
+        }
+        if ((op % 4096 == 0 || op + 1 == ops) && !sameEntries(map, model, op)) {
+            return false;
+        }
+    }
+    std::cerr << name << ": " << ops << " operations, " << grown << " growths" << std::endl;
+    return true;
+}
+
+// erased slots of a full group stay deleted, inserting into the other
+// group then uses up the growth left while the map is less than half full,
+// so the next insert rehashes at the same capacity
+static bool sameSizeRehash()
+{
+    CheckedFlatMap<IdentityHash> map;
+    Model model;
+    map.reserve(2 * FLAT_MAP_GROUP - 2 * FLAT_MAP_GROUP / 8);
+    if (map.capacity() != 2 * FLAT_MAP_GROUP) {
+        return failed("reserve for two groups", 0);
+    }
+    // even keys start in group 0, odd keys in group 1
+    for (uint64_t i = 0; i < FLAT_MAP_GROUP; i++) {
+        map[2 * i] = model[2 * i] = i;
+    }
+    for (uint64_t i = 0; i < FLAT_MAP_GROUP; i++) {
+        map.erase(2 * i);
+        model.erase(2 * i);
+    }
+    uint64_t i = 0;
+    while (map.growthLeft() > 0) {
+        map[2 * i + 1] = model[2 * i + 1] = i;
+        i++;
+    }
+    map[2 * i + 1] = model[2 * i + 1] = i;
+    if (map.capacity() != 2 * FLAT_MAP_GROUP || map.growthLeft() == 0) {
+        return failed("same-size rehash", i);
+    }
+    if (!sameEntries(map, model, i)) {
+        return false;
+    }
+    // the rehashed map keeps working
+    return compare("after same-size rehash", map, model, 4 * FLAT_MAP_GROUP, 100000, SIZE_MAX, 4);
+}
+
+int main()
+{
+    bool ok = true;
+    {
+        // at most 14 of 16 slots are used, so this stays a single group
+        CheckedFlatMap<std::hash<uint64_t>> map;
+        Model model;
+        ok &= compare("single group", map, model, 14, 200000, FLAT_MAP_GROUP, 1);
+    }
+    {
+        CheckedFlatMap<std::hash<uint64_t>> map;
+        Model model;
+        ok &= compare("growing", map, model, 5000, 1000000, SIZE_MAX, 2);
+    }
+    {
+        CheckedFlatMap<CollidingHash> map;
+        Model model;
+        ok &= compare("colliding", map, model, 300, 200000, SIZE_MAX, 3);
+    }
+    ok &= sameSizeRehash();
+    {
+        // reserve makes room up front and keeps the entries
+        CheckedFlatMap<std::hash<uint64_t>> map;
+        Model model;
+        for (uint64_t key = 0; key < 100; key++) {
+            map[key] = model[key] = key;
+        }
+        map.reserve(10000);
+        const size_t capacity = map.capacity();
+        for (uint64_t key = 100; key < 10000; key++) {
+            map[key] = model[key] = key;
+        }
+        if (map.capacity() != capacity) {
+            ok = failed("reserve capacity", 10000);
+        }
+        ok &= sameEntries(map, model, 10000);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <random>
+#include <vector>
+#include "caches/lru_table.h"
+
+/*
+  randomized differential test of LRUTable and LRUTable32 against std::list
+
+  requests on a small set of objects move them to the front or insert
+  them, the table evicts its least recently used object when it is full,
+  and random objects are erased from the middle. Erasing shifts later
+  slots back and relinks their neighbors, so after every operation the
+  recency list is walked in both directions and compared with the list
+*/
+
+template<class Object>
+class CheckedLRUTable : public BasicLRUTable<Object>
+{
+public:
+    typedef BasicLRUTable<Object> Table;
+
+    // true if the table holds exactly the objects of model, in its order,
+    // with consistent links in both directions
+    bool matches(const std::list<Object>& model) const {
+        if (this->size() != model.size()) {
+            return false;
+        }
+        typename Table::Index i = this->_head;
+        typename Table::Index prev = Table::NIL;
+        for (const Object& obj : model) {
+            if (i == Table::NIL || this->_slots[i].prev != prev || !(this->object(i) == obj)
+                || this->find(obj) != i) {
+                return false;
+            }
+            prev = i;
+            i = this->_slots[i].next;
+        }
+        return i == Table::NIL && this->_tail == prev;
+    }
+};
+
+static bool failed(const char* name, const char* what, uint64_t op)
+{
+    std::cerr << "check failed: " << name << " " << what << " at operation " << op << std::endl;
+    return false;
+}
+
+// ops random requests and erases on objects [0, objects), at most capacity cached
+template<class Object>
+static bool compare(const char* name, uint64_t objects, uint64_t capacity, uint64_t ops,
+                    uint64_t seed)
+{
+    std::mt19937_64 rnd(seed);
+    CheckedLRUTable<Object> table;
+    typedef typename CheckedLRUTable<Object>::Table Table;
+    std::list<Object> model;
+    // objects with the same id and a different size are different objects
+    std::vector<Object> universe;
+    for (uint64_t i = 0; i < objects; i++) {
+        universe.push_back(Object(i / 2, 1 + i % 2 + (i % 7) * 1000));
+    }
+    for (uint64_t op = 0; op < ops; op++) {
+        const Object& obj = universe[rnd() % objects];
+        if (rnd() % 4 != 0) {
+            // a request: hit or insert, evict the least recently used beyond capacity
+            const typename Table::Index i = table.find(obj);
+            auto it = model.begin();
+            while (it != model.end() && !(*it == obj)) {
+                ++it;
+            }
+            if ((i == Table::NIL) != (it == model.end())) {
+                return failed(name, "find", op);
+            }
+            if (i != Table::NIL) {
+                table.moveToFront(i);
+                model.splice(model.begin(), model, it);
+            } else {
+                if (table.size() == capacity) {
+                    if (!(table.object(table.back()) == model.back())) {
+                        return failed(name, "back", op);
+                    }
+                    table.erase(table.back());
+                    model.pop_back();
+                }
+                table.pushFront(obj);
+                model.push_front(obj);
+            }
+        } else if (!model.empty()) {
+            // erase an object from anywhere in the list
+            auto it = model.begin();
+            std::advance(it, rnd() % model.size());
+            const typename Table::Index i = table.find(*it);
+            if (i == Table::NIL) {
+                return failed(name, "find before erase", op);
+            }
+            table.erase(i);
+            model.erase(it);
+        }
+        if (!table.matches(model)) {
+            return failed(name, "recency list", op);
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    // a few objects in the 16 slots of an empty table
+    ok &= compare<CacheObject>("LRUTable small", 12, 6, 50000, 1);
+    ok &= compare<CacheObject32>("LRUTable32 small", 12, 6, 50000, 2);
+    // grows through several rehashes, evicts and erases in long probe runs
+    ok &= compare<CacheObject>("LRUTable", 600, 200, 100000, 3);
+    ok &= compare<CacheObject32>("LRUTable32", 600, 200, 100000, 4);
+
+    // reserve keeps the recency order
+    CheckedLRUTable<CacheObject> table;
+    std::list<CacheObject> model;
+    for (uint64_t i = 0; i < 100; i++) {
+        table.pushFront(CacheObject(i, 1));
+        model.push_front(CacheObject(i, 1));
+    }
+    table.reserve(10000);
+    if (!table.matches(model)) {
+        ok = failed("LRUTable", "reserve", 100);
+    }
+    return ok ? 0 : 1;
+}
@@ -2,15 +2,84 @@
 #include <stdexcept>
 #include <stdio.h>
 #include <iostream>
-#include <fstream>
 #include <random>
-#include <list>
-#include <iomanip>
+#include <vector>
+#include <future>
+#include <thread>
+#include <cmath>
+#include <unistd.h>
+#include "traces/binary_trace.h"
+#include "traces/columnar_trace.h"
+#include "traces/text_trace_writer.h"
 
 using namespace std;
 
-typedef tuple<long double, unsigned long> fi_pair_t;
-typedef list<fi_pair_t>::iterator list_iterator_t;
+// expected number of requests generated per time slice, a slice buffer
+// takes about 25 MB
+const double SLICE_REQUESTS = 1 << 20;
+
+// default -j, each thread holds two slices
+const unsigned int DEFAULT_THREADS = 8;
+
+// Walker's alias method: picks object i with probability weight[i] / sum
+// of all weights in constant time (Vose's construction, linear time)
+class AliasTable
+{
+protected:
+  vector<float> _prob; // probability of keeping a column's own object
+  vector<uint32_t> _alias; // the column's other object
+  double _sum;
+
+public:
+  // consumes the weights, scaled in place so that they average 1
+  AliasTable(vector<double> weight)
+    : _prob(weight.size()),
+      _alias(weight.size()),
+      _sum(0)
+  {
+    const uint32_t n = weight.size();
+    for (double w: weight)
+      _sum += w;
+    // columns below and above average, as stacks growing from either end
+    vector<uint32_t> work(n);
+    uint32_t small = 0, large = n;
+    for (uint32_t i = 0; i < n; i++) {
+      weight[i] *= n / _sum;
+      _alias[i] = i;
+      if (weight[i] < 1.0)
+        work[small++] = i;
+      else
+        work[--large] = i;
+    }
+    while (small > 0 && large < n) {
+      const uint32_t s = work[--small], l = work[large];
+      _prob[s] = weight[s];
+      _alias[s] = l;
+      weight[l] -= 1.0 - weight[s];
+      if (weight[l] < 1.0) {
+        large++;
+        work[small++] = l;
+      }
+    }
+    // the rest are full columns, up to rounding
+    for (uint32_t i = 0; i < small; i++)
+      _prob[work[i]] = 1.0;
+    for (uint32_t i = large; i < n; i++)
+      _prob[work[i]] = 1.0;
+  }
+
+  // sum of all weights
+  double sum() const {
+    return _sum;
+  }
+
+  template<class Generator>
+  uint32_t sample(Generator& gen, uniform_real_distribution<>& unit) const {
+    const double u = unit(gen) * _prob.size();
+    const uint32_t column = min<uint64_t>(u, _prob.size() - 1);
+    return (u - column < _prob[column]) ? column : _alias[column];
+  }
+};
 
 // inversion method for bounded Pareto
 // uniform sample us, shape a (alpha), lower bound l, upper bound h
@@ -20,74 +89,165 @@ double rbpareto(double us, double a, double l, double h)
   return( l/ pow( 1+us*(pow(l/h,a)-1), 1.0/a) );
 }
 
+// generate all requests in the time slice [begin, end)
+//
+// every object is an independent Poisson process, and their merge is one
+// Poisson process with the sum of the rates whose arrivals each belong to
+// object i with probability rate[i] / sum of rates. So a slice draws the
+// aggregate arrivals in time order and picks their objects from the alias
+// table, in time proportional to its requests. Slices are independent of
+// each other, so they can be generated in parallel
+void generateSlice(const AliasTable& objects, const vector<uint64_t>& size,
+                   uint64_t seed, uint64_t slice, double begin, double end,
+                   vector<TraceRecord>& out)
+{
+  seed_seq seq{seed, slice};
+  mt19937_64 rnd_gen(seq);
+  exponential_distribution<> iaRand(objects.sum());
+  uniform_real_distribution<> unit(0, 1);
+
+  // a Poisson count rarely exceeds its mean by 8 standard deviations,
+  // so the buffer is not doubled while it is filled
+  const double expected = objects.sum() * (end - begin);
+  out.clear();
+  out.reserve(expected + 8 * sqrt(expected) + 1);
+  TraceRecord rec;
+  for (double t = begin + iaRand(rnd_gen); t < end; t += iaRand(rnd_gen)) {
+    rec.t = llround(1000*t);
+    rec.id = objects.sample(rnd_gen, unit);
+    rec.size = size[rec.id];
+    out.push_back(rec);
+  }
+}
+
+// generate the slices on threads threads and stream them to the output in
+// time order, the next round of slices is generated while the current one
+// is written, so memory is bounded by 2*threads slices
+template<class Writer>
+int generate(const AliasTable& objects, const vector<uint64_t>& size, double reps,
+             uint64_t seed, unsigned int threads, const string& outputname)
+{
+  Writer outfile;
+  if (!outfile.open(outputname))
+    return 1;
+
+  const double expected = objects.sum() * reps;
+  // the slicing does not depend on threads, so a seed gives the same trace
+  const uint64_t slices = max<uint64_t>(1, ceil(expected / SLICE_REQUESTS));
+  const double sliceLength = reps / slices;
+
+  vector<vector<TraceRecord> > current(threads), next(threads);
+  vector<future<void> > pending;
+  auto launch = [&](uint64_t first, vector<vector<TraceRecord> >& bufs) {
+    pending.clear();
+    for (uint64_t s = first; s < min<uint64_t>(first + threads, slices); s++) {
+      vector<TraceRecord>& buf = bufs[s - first];
+      const double begin = s * sliceLength;
+      const double end = (s + 1 == slices) ? reps : (s + 1) * sliceLength;
+      pending.push_back(async(launch::async, generateSlice, cref(objects), cref(size),
+                              seed, s, begin, end, ref(buf)));
+    }
+  };
+
+  uint64_t count = 0;
+  launch(0, current);
+  for (uint64_t first = 0; first < slices; first += threads) {
+    for (auto& f: pending)
+      f.get();
+    const uint64_t generated = min<uint64_t>(threads, slices - first);
+    if (first + threads < slices)
+      launch(first + threads, next);
+    for (uint64_t s = 0; s < generated; s++) {
+      for (const TraceRecord& rec: current[s]) {
+        if (!outfile.write(rec)) {
+          cerr << "write error " << outputname << endl;
+          return 1;
+        }
+      }
+      count += current[s].size();
+    }
+    swap(current, next);
+  }
+  if (!outfile.close()) {
+    cerr << "write error " << outputname << endl;
+    return 1;
+  }
+  cout << "finished output of " << count << " requests.\n";
+  return 0;
+}
+
 int main (int argc, char* argv[])
 {
   // parameters
-  if(argc!=7) {
-    cout << "\n number_of_objects repetition_count pareto_shape lower_pareto_bound higher_pareto_bound outputname\n";
+  string format = "text";
+  unsigned int threads = max(1u, min(DEFAULT_THREADS, thread::hardware_concurrency()));
+  random_device rd;
+  uint64_t seed = rd();
+  int opt;
+  while ((opt = getopt(argc, argv, "o:j:s:")) != -1) {
+    switch (opt) {
+    case 'o':
+      format = optarg;
+      break;
+    case 'j':
+      threads = max(1ul, stoul(optarg));
+      break;
+    case 's':
+      seed = stoull(optarg);
+      break;
+    default:
+      return 1;
+    }
+  }
+  if(argc - optind != 6) {
+    cout << "\n [-o text|binary|columnar] [-j threads] [-s seed] number_of_objects repetition_count pareto_shape lower_pareto_bound higher_pareto_bound outputname\n";
+    cout << " -j: generating threads (default: cores, at most " << DEFAULT_THREADS << "), each buffers about 50 MB of requests\n";
+    return 1;
+  }
+  argv += optind;
+  const long no_objs = atol(argv[0]);
+  const double reps = atof(argv[1]);
+  const double shape = atof(argv[2]);
+  const double lowerb = atof(argv[3]);
+  const double higherb = atof(argv[4]);
+  const string outputname(argv[5]);
+  if (no_objs < 1 || no_objs > UINT32_MAX || reps <= 0) {
+    cerr << "invalid number of objects or repetition count\n";
     return 1;
   }
-  const long no_objs = atoi(argv[1]);
-  const long reps = atoi(argv[2]);
-  const double shape = atof(argv[3]);
-  const double lowerb = atof(argv[4]);
-  const double higherb = atof(argv[5]);
-  const string outputname(argv[6]);
-
-  auto * size = new long[no_objs];
-  list<fi_pair_t> reqseq;
 
   // initialize object sizes
-  random_device rd;
-  mt19937 rnd_gen (rd ());
+  vector<uint64_t> size(no_objs);
+  mt19937_64 rnd_gen(seed);
   double mean_size=0.0;
   uniform_real_distribution<> urng(0, 1);
   for (long i = 0; i < no_objs; i++) {
-    double us = urng(rnd_gen);
+    double us;
     do
       {
-	us = urng(rnd_gen);
+	do
+	  us = urng(rnd_gen);
+	while ((us == 0) || (us == 1));
+	size[i]=rbpareto(us,shape,lowerb,higherb);
       }
-    while ((us == 0) || (us == 1));
-    do
-    {
-        size[i]=rbpareto(us,shape,lowerb,higherb);
-    }
     while (size[i]<lowerb || size[i]>higherb);
     mean_size+=size[i];
   }
   cout << "finished sizes. mean_size: " << mean_size/static_cast<double>(no_objs) << "\n";
 
-  // initialize req sequence
-  for (long i = 0; i < no_objs; i++) {
-    const long double rateH = 1/(pow(i+1,0.9));
-    exponential_distribution<> iaRandH (rateH);
-    long double globalTime = iaRandH(rnd_gen);
-    while(globalTime<reps) {
-      reqseq.push_back(fi_pair_t(globalTime,i));
-      globalTime += iaRandH(rnd_gen);
-    }
-    //    cout << "markov high " << testh/testhc << " number " << testhc << " markov low " << testl/testlc << " number " << testlc << " changed states " << testchange << "\n";
-  }
-  // sort tuples lexicographically, i.e., by time
-  cout << "finished raw req sequence.\n";
-  reqseq.sort();
-  cout << "finished sorting req.\n";
-
-  ofstream outfile;
-  outfile.open(outputname);
-  outfile<<fixed<<setprecision(0); // turn of scientific notation
-
-  // output request sequence
-  list_iterator_t rit;
-  for (rit=reqseq.begin(); rit != reqseq.end(); ++rit) {
-    outfile << 1000*get<0>(*rit) << " " << get<1>(*rit) << " " << size[get<1>(*rit)] << "\n"; 
-  }
-
-  cout << "finished output.\n";
-  outfile.close();
+  // request rates of the objects' Poisson arrival processes
+  vector<double> rate(no_objs);
+  for (long i = 0; i < no_objs; i++)
+    rate[i] = 1/(pow(i+1,0.9));
+  const AliasTable objects(move(rate));
 
-  delete size;
-
-  return 0;
+  if (format == "text") {
+    return generate<TextTraceWriter>(objects, size, reps, seed, threads, outputname);
+  } else if (format == "binary") {
+    return generate<BinaryTraceWriter>(objects, size, reps, seed, threads, outputname);
+  } else if (format == "columnar") {
+    return generate<ColumnarTraceWriter>(objects, size, reps, seed, threads, outputname);
+  }
+  cerr << "unknown output format " << format << endl;
+  return 1;
 }
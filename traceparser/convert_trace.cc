@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "traces/trace_reader.h"
+#include "traces/binary_trace.h"
+#include "traces/columnar_trace.h"
+#include "traces/text_trace_writer.h"
+#include "traces/id_assigner.h"
+#include "trace_dialects.h"
+
+using namespace std;
+
+// rewrite traces in any input dialect into the text, binary or columnar trace format
+template<class Writer>
+int convert(const vector<string>& inputs, const char* dest,
+            const DialectParser* parser, unsigned int threads)
+{
+  Writer outfile;
+  if(!outfile.open(dest))
+    return 1;
+
+  cout << "running..." << endl;
+
+  // dense ids are assigned across all input files
+  const bool renumber = parser != nullptr && parser->renumber();
+  IdAssigner ids;
+  uint64_t t = 0;
+  for(const string& input: inputs) {
+    unique_ptr<TraceReader> trace = TraceReader::create_unique(input, threads, parser);
+    if(trace == nullptr)
+      return 1;
+
+    const TraceRecord* batch;
+    size_t n;
+    TraceRecord rec;
+    while((n = trace->nextBatch(batch)) > 0) {
+      for(size_t i=0; i<n; i++) {
+        rec = batch[i];
+        t++;
+        if(renumber) {
+          rec.t = t;
+          rec.id = ids.assign(rec.id);
+        }
+        if(!outfile.write(rec)) {
+          cerr << "write error " << dest << endl;
+          return 1;
+        }
+      }
+    }
+    if(!trace->good()) {
+      cerr << "conversion failed" << endl;
+      return 1;
+    }
+  }
+  if(!outfile.close()) {
+    cerr << "write error " << dest << endl;
+    return 1;
+  }
+
+  cout << "rewrote " << t << " requests";
+  if(renumber)
+    cout << " of " << ids.size() << " objects";
+  cout << endl;
+  return 0;
+}
+
+int main (int argc, char* argv[])
+{
+
+  // parameters
+  string dialect = "native";
+  string format = "text";
+  string cacheId = "cp4006";
+  unsigned int threads = TraceReader::defaultThreads();
+  int opt;
+  while ((opt = getopt(argc, argv, "i:o:c:j:")) != -1) {
+    switch (opt) {
+    case 'i':
+      dialect = optarg;
+      break;
+    case 'o':
+      format = optarg;
+      break;
+    case 'c':
+      cacheId = optarg;
+      break;
+    case 'j':
+      threads = stoul(optarg);
+      break;
+    default:
+      return 1;
+    }
+  }
+  if(argc - optind < 2) {
+    cerr << "convert_trace [-i native|http|simple|wmf|single|hex] [-o text|binary|columnar]"
+         << " [-c wmfCacheId] [-j threads] inputTrace... outputTrace" << endl;
+    return 1;
+  }
+  vector<string> inputs(argv + optind, argv + argc - 1);
+  const char* dest = argv[argc - 1];
+
+  unique_ptr<DialectParser> parser;
+  if(dialect != "native") {
+    parser = DialectParser::create_unique(dialect, cacheId);
+    if(parser == nullptr) {
+      cerr << "unknown input dialect " << dialect << endl;
+      return 1;
+    }
+  }
+
+  if(format == "text") {
+    return convert<TextTraceWriter>(inputs, dest, parser.get(), threads);
+  } else if(format == "binary") {
+    return convert<BinaryTraceWriter>(inputs, dest, parser.get(), threads);
+  } else if(format == "columnar") {
+    return convert<ColumnarTraceWriter>(inputs, dest, parser.get(), threads);
+  }
+  cerr << "unknown output format " << format << endl;
+  return 1;
+}
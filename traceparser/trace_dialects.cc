@@ -0,0 +1,231 @@
+#include <cstring>
+#include "trace_dialects.h"
+#include "traces/text_parse.h"
+#include "traces/id_assigner.h"
+
+std::unique_ptr<DialectParser> DialectParser::create_unique(const std::string& name,
+                                                            const std::string& cacheId)
+{
+    std::unique_ptr<DialectParser> parser;
+    if (name == "http") {
+        parser.reset(new HttpLineParser());
+    } else if (name == "simple") {
+        parser.reset(new SimpleLineParser());
+    } else if (name == "wmf") {
+        parser.reset(new WikimediaLineParser(cacheId));
+    } else if (name == "single") {
+        parser.reset(new SingleColumnLineParser());
+    } else if (name == "hex") {
+        parser.reset(new HexLineParser());
+    }
+    return parser;
+}
+
+// end of the field starting at p, fields are separated by delim
+static inline const char* fieldEnd(const char* p, const char* end, char delim)
+{
+    const char* e = static_cast<const char*>(memchr(p, delim, end - p));
+    return e != nullptr ? e : end;
+}
+
+// find field number n (1-based) of a line, false if the line has fewer fields
+static inline bool findField(const char* begin, const char* end, char delim, int n,
+                             const char*& fieldBegin, const char*& fieldStop)
+{
+    const char* p = begin;
+    for (int i = 1; i < n; i++) {
+        p = fieldEnd(p, end, delim);
+        if (p == end) {
+            return false;
+        }
+        p++;
+    }
+    fieldBegin = p;
+    fieldStop = fieldEnd(p, end, delim);
+    return true;
+}
+
+// parse a leading, optionally negative, decimal number of a field
+static inline bool parseLong(const char* p, const char* end, int64_t& value)
+{
+    p = skipBlanks(p, end);
+    const bool negative = (p < end && *p == '-');
+    uint64_t v = 0;
+    if (parseUInt(p + negative, end, v) == nullptr) {
+        return false;
+    }
+    value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    return true;
+}
+
+// parse a whole token [p, end) as an optionally negative decimal number
+static inline bool parseLongToken(const char* p, const char* end, int64_t& value)
+{
+    const bool negative = (p < end && *p == '-');
+    uint64_t v = 0;
+    if (parseUInt(p + negative, end, v) != end) {
+        return false;
+    }
+    value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    return true;
+}
+
+// end of a whitespace-separated token
+static inline const char* tokenEnd(const char* p, const char* end)
+{
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+/*
+  BU HTTP
+*/
+int HttpLineParser::parse(const char* begin, const char* end, TraceRecord& rec) const
+{
+    const char *id1, *id1End, *id2, *id2End, *size, *sizeEnd;
+    if (!findField(begin, end, ' ', 2, id1, id1End)
+        || !findField(begin, end, ' ', 3, id2, id2End)
+        || !findField(begin, end, ' ', 10, size, sizeEnd)) {
+        return 0;
+    }
+    int64_t s;
+    if (!parseLong(size, sizeEnd, s) || s < 1) {
+        return 0;
+    }
+    // the object is identified by the concatenation of fields 2 and 3
+    const size_t len1 = id1End - id1;
+    const size_t len2 = id2End - id2;
+    char buf[256];
+    if (len1 + len2 <= sizeof(buf)) {
+        memcpy(buf, id1, len1);
+        memcpy(buf + len1, id2, len2);
+        rec.id = hashBytes(buf, len1 + len2);
+    } else {
+        std::string id(id1, len1);
+        id.append(id2, len2);
+        rec.id = hashBytes(id.data(), id.size());
+    }
+    rec.t = 0;
+    rec.size = s;
+    return 1;
+}
+
+/*
+  four columns
+*/
+int SimpleLineParser::parse(const char* begin, const char* end, TraceRecord& rec) const
+{
+    const char* p = skipBlanks(begin, end);
+    if (p == end) {
+        return 0;
+    }
+    int64_t values[4];
+    for (int i = 0; i < 4; i++) {
+        const char* e = tokenEnd(p, end);
+        if (!parseLongToken(p, e, values[i])) {
+            return -1;
+        }
+        p = skipBlanks(e, end);
+    }
+    if (p != end) {
+        return -1;
+    }
+    if (values[2] < 1) {
+        return 0;
+    }
+    rec.t = 0;
+    rec.id = values[1];
+    rec.size = values[2];
+    return 1;
+}
+
+/*
+  Wikimedia TSV
+*/
+int WikimediaLineParser::parse(const char* begin, const char* end, TraceRecord& rec) const
+{
+    const char *id, *idEnd, *size, *sizeEnd, *xcache, *xcacheEnd;
+    int64_t i, s;
+    if (!findField(begin, end, '\t', 1, id, idEnd)
+        || !findField(begin, end, '\t', 4, size, sizeEnd)
+        || !findField(begin, end, '\t', 6, xcache, xcacheEnd)
+        || !parseLong(id, idEnd, i)
+        || !parseLong(size, sizeEnd, s)
+        || s < 1) {
+        return 0;
+    }
+    // match the cache in the 7th token of the X-Cache field
+    const char *cache, *cacheEnd;
+    if (!findField(xcache, xcacheEnd, ' ', 7, cache, cacheEnd)
+        || size_t(cacheEnd - cache) != _cacheId.size()
+        || memcmp(cache, _cacheId.data(), _cacheId.size()) != 0) {
+        return 0;
+    }
+    rec.t = 0;
+    rec.id = i;
+    rec.size = s;
+    return 1;
+}
+
+/*
+  single column
+*/
+int SingleColumnLineParser::parse(const char* begin, const char* end, TraceRecord& rec) const
+{
+    const char* p = skipBlanks(begin, end);
+    if (p == end) {
+        return 0;
+    }
+    if ((p = parseUInt(p, end, rec.id)) == nullptr || skipBlanks(p, end) != end) {
+        return -1;
+    }
+    rec.t = 0;
+    rec.size = 1;
+    return 1;
+}
+
+/*
+  hexadecimal ids
+*/
+int HexLineParser::parse(const char* begin, const char* end, TraceRecord& rec) const
+{
+    const char* p = skipBlanks(begin, end);
+    if (p == end) {
+        return 0;
+    }
+    // first column is ignored
+    p = skipBlanks(tokenEnd(p, end), end);
+    const char* idEnd = tokenEnd(p, end);
+    if (idEnd - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+    }
+    if (p == idEnd || idEnd - p > 16) {
+        return -1;
+    }
+    uint64_t id = 0;
+    for (; p < idEnd; p++) {
+        const char c = *p;
+        unsigned int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        id = (id << 4) | digit;
+    }
+    // third column is ignored
+    p = skipBlanks(idEnd, end);
+    if (p == end || skipBlanks(tokenEnd(p, end), end) != end) {
+        return -1;
+    }
+    rec.t = 0;
+    rec.id = id;
+    rec.size = 1;
+    return 1;
+}
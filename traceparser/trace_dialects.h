@@ -0,0 +1,95 @@
+#ifndef TRACE_DIALECTS_H
+#define TRACE_DIALECTS_H
+
+#include <memory>
+#include <string>
+#include "traces/trace_reader.h"
+
+/*
+  DialectParser: input formats of convert_trace
+
+  parsers return the raw object id (or a hash of it) in rec.id,
+  dialects that renumber get dense ids and request counter times assigned
+  by the converter in trace order
+*/
+class DialectParser : public LineParser
+{
+public:
+    DialectParser() : LineParser() {}
+    virtual ~DialectParser() {}
+
+    // assign dense ids and times 1, 2, 3, ... to the parsed requests
+    virtual bool renumber() const {
+        return true;
+    }
+
+    // create a parser by dialect name, nullptr for unknown dialects
+    static std::unique_ptr<DialectParser> create_unique(const std::string& name,
+                                                        const std::string& cacheId);
+};
+
+/*
+  BU HTTP traces (1999-011-usertrace-98): space-separated, a header line,
+  the object is identified by fields 2 and 3, the size is field 10
+*/
+class HttpLineParser : public DialectParser
+{
+public:
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const;
+    virtual uint64_t headerLines() const {
+        return 1;
+    }
+};
+
+/*
+  four columns: time, id, size, other
+*/
+class SimpleLineParser : public DialectParser
+{
+public:
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const;
+};
+
+/*
+  Wikimedia TSV logs: id in field 1, size in field 4, requests are kept
+  if the 7th space-separated token of field 6 (X-Cache) is the given cache
+*/
+class WikimediaLineParser : public DialectParser
+{
+protected:
+    std::string _cacheId;
+
+public:
+    WikimediaLineParser(const std::string& cacheId)
+        : DialectParser(),
+          _cacheId(cacheId)
+    {
+    }
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const;
+};
+
+/*
+  one decimal id per line, written as (0, id, 1)
+*/
+class SingleColumnLineParser : public DialectParser
+{
+public:
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const;
+    virtual bool renumber() const {
+        return false;
+    }
+};
+
+/*
+  three columns, the second is a hexadecimal id, written as (0, id, 1)
+*/
+class HexLineParser : public DialectParser
+{
+public:
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const;
+    virtual bool renumber() const {
+        return false;
+    }
+};
+
+#endif /* TRACE_DIALECTS_H */
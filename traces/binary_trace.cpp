@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binary_trace.h"
+
+bool isBinaryTrace(const std::string& path)
+{
+    char magic[sizeof(BINARY_TRACE_MAGIC)];
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    const bool isBinary = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+        && memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return isBinary;
+}
+
+/*
+  BinaryTraceReader
+*/
+BinaryTraceReader::BinaryTraceReader(const std::string& path)
+    : TraceReader(),
+      _map(nullptr),
+      _mapLength(0),
+      _records(nullptr),
+      _count(0),
+      _pos(0)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "cannot open trace " << path << std::endl;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(BinaryTraceHeader)) {
+        std::cerr << "truncated binary trace " << path << std::endl;
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "cannot mmap trace " << path << std::endl;
+        return;
+    }
+    // the trace is replayed front to back exactly once: read ahead, drop behind
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    const BinaryTraceHeader* header = static_cast<const BinaryTraceHeader*>(map);
+    const uint64_t maxCount = (st.st_size - sizeof(BinaryTraceHeader)) / sizeof(TraceRecord);
+    if (memcmp(header->magic, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) != 0
+        || header->version != BINARY_TRACE_VERSION
+        || header->recordSize != sizeof(TraceRecord)
+        || header->count > maxCount) {
+        std::cerr << "invalid binary trace header " << path << std::endl;
+        munmap(map, st.st_size);
+        return;
+    }
+    _map = static_cast<const char*>(map);
+    _mapLength = st.st_size;
+    _records = reinterpret_cast<const TraceRecord*>(_map + sizeof(BinaryTraceHeader));
+    _count = header->count;
+}
+
+BinaryTraceReader::~BinaryTraceReader()
+{
+    if (_map != nullptr) {
+        munmap(const_cast<char*>(_map), _mapLength);
+    }
+}
+
+size_t BinaryTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    // records are handed out directly from the mapping
+    const uint64_t n = std::min<uint64_t>(TRACE_BATCH_SIZE, _count - _pos);
+    batch = _records + _pos;
+    _pos += n;
+    return n;
+}
+
+uint64_t BinaryTraceReader::seekRequest(uint64_t request)
+{
+    // fixed-size records are their own index
+    _pos = std::min(request, _count);
+    return _pos;
+}
+
+uint64_t BinaryTraceReader::seekTime(uint64_t t)
+{
+    const TraceRecord* rec = std::lower_bound(_records, _records + _count, t,
+                                              [](const TraceRecord& r, uint64_t v) { return r.t < v; });
+    _pos = rec - _records;
+    return _pos;
+}
+
+/*
+  BinaryTraceWriter
+*/
+BinaryTraceWriter::BinaryTraceWriter()
+    : _outfile(NULL),
+      _count(0)
+{
+}
+
+BinaryTraceWriter::~BinaryTraceWriter()
+{
+    if (_outfile != NULL) {
+        close();
+    }
+}
+
+bool BinaryTraceWriter::open(const std::string& path)
+{
+    _outfile = fopen(path.c_str(), "wb");
+    if (_outfile == NULL) {
+        std::cerr << "cannot open output " << path << std::endl;
+        return false;
+    }
+    _count = 0;
+    _buffer.reserve(TRACE_BATCH_SIZE * 16);
+    // header is rewritten with the final count on close()
+    BinaryTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    return fwrite(&header, sizeof(header), 1, _outfile) == 1;
+}
+
+bool BinaryTraceWriter::flush()
+{
+    const size_t n = _buffer.size();
+    const bool ok = n == 0 || fwrite(_buffer.data(), sizeof(TraceRecord), n, _outfile) == n;
+    _count += n;
+    _buffer.clear();
+    return ok;
+}
+
+bool BinaryTraceWriter::close()
+{
+    bool ok = flush();
+    BinaryTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+    header.version = BINARY_TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.count = _count;
+    ok = ok && fseek(_outfile, 0, SEEK_SET) == 0
+        && fwrite(&header, sizeof(header), 1, _outfile) == 1;
+    ok = (fclose(_outfile) == 0) && ok;
+    _outfile = NULL;
+    return ok;
+}
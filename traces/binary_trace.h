@@ -0,0 +1,85 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <cstdio>
+#include <vector>
+#include "traces/trace_reader.h"
+
+/*
+  Binary trace format
+
+  a fixed-size header followed by count TraceRecords (time, id, size),
+  each field a little-endian uint64_t
+*/
+const char BINARY_TRACE_MAGIC[8] = {'W', 'C', 'S', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t BINARY_TRACE_VERSION = 1;
+
+struct BinaryTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(TraceRecord)
+    uint64_t count; // number of records
+    uint64_t reserved;
+};
+
+// check whether a file starts with the binary trace magic
+bool isBinaryTrace(const std::string& path);
+
+/*
+  BinaryTraceReader: memory-maps a binary trace and hands out records in place
+*/
+class BinaryTraceReader : public TraceReader
+{
+protected:
+    const char* _map; // mapped file
+    size_t _mapLength;
+    const TraceRecord* _records;
+    uint64_t _count;
+    uint64_t _pos;
+
+public:
+    BinaryTraceReader(const std::string& path);
+    virtual ~BinaryTraceReader();
+
+    bool isOpen() const {
+        return _map != nullptr;
+    }
+    uint64_t count() const {
+        return _count;
+    }
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual uint64_t seekRequest(uint64_t request);
+    virtual uint64_t seekTime(uint64_t t);
+};
+
+/*
+  BinaryTraceWriter: buffered writer for binary traces
+*/
+class BinaryTraceWriter
+{
+protected:
+    FILE* _outfile;
+    std::vector<TraceRecord> _buffer;
+    uint64_t _count;
+
+    bool flush();
+
+public:
+    BinaryTraceWriter();
+    ~BinaryTraceWriter();
+
+    bool open(const std::string& path);
+    bool write(const TraceRecord& rec) {
+        _buffer.push_back(rec);
+        if (_buffer.size() >= TRACE_BATCH_SIZE * 16) {
+            return flush();
+        }
+        return true;
+    }
+    // flush remaining records and write the final record count into the header
+    bool close();
+};
+
+#endif /* BINARY_TRACE_H */
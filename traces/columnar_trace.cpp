@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "columnar_trace.h"
+
+// varint (LEB128) and zigzag helpers
+static inline void putVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static inline const uint8_t* getVarint(const uint8_t* p, const uint8_t* end, uint64_t& v)
+{
+    v = 0;
+    for (unsigned int shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (b < 0x80) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+static inline uint64_t zigzag(uint64_t delta)
+{
+    return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t v)
+{
+    return (v >> 1) ^ (~(v & 1) + 1);
+}
+
+bool isColumnarTrace(const std::string& path)
+{
+    char magic[sizeof(COLUMNAR_TRACE_MAGIC)];
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    const bool isColumnar = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+        && memcmp(magic, COLUMNAR_TRACE_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return isColumnar;
+}
+
+/*
+  ColumnarTraceReader
+*/
+ColumnarTraceReader::ColumnarTraceReader(const std::string& path, unsigned int threads)
+    : TraceReader(),
+      _map(nullptr),
+      _mapLength(0),
+      _index(nullptr),
+      _blockCount(0),
+      _count(0),
+      _decodeTimes(true),
+      _good(true),
+      _threads(threads > 0 ? threads : 1),
+      _ring(1),
+      _nextClaim(0),
+      _current(0),
+      _pos(0),
+      _stop(false)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "cannot open trace " << path << std::endl;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0
+        || size_t(st.st_size) < sizeof(ColumnarTraceHeader) + sizeof(ColumnarTraceFooter)) {
+        std::cerr << "truncated columnar trace " << path << std::endl;
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "cannot mmap trace " << path << std::endl;
+        return;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(map);
+    const ColumnarTraceHeader* header = reinterpret_cast<const ColumnarTraceHeader*>(base);
+    const ColumnarTraceFooter* footer =
+        reinterpret_cast<const ColumnarTraceFooter*>(base + st.st_size - sizeof(ColumnarTraceFooter));
+    const uint64_t indexSpace = st.st_size - sizeof(ColumnarTraceFooter);
+    if (memcmp(header->magic, COLUMNAR_TRACE_MAGIC, sizeof(COLUMNAR_TRACE_MAGIC)) != 0
+        || header->version != COLUMNAR_TRACE_VERSION
+        || memcmp(footer->magic, COLUMNAR_TRACE_MAGIC, sizeof(COLUMNAR_TRACE_MAGIC)) != 0
+        || footer->indexOffset > indexSpace
+        || footer->blockCount > (indexSpace - footer->indexOffset) / sizeof(ColumnarBlockIndex)) {
+        std::cerr << "invalid columnar trace " << path << std::endl;
+        munmap(map, st.st_size);
+        return;
+    }
+    // block sizes bound the memory of decoded blocks
+    const ColumnarBlockIndex* index = reinterpret_cast<const ColumnarBlockIndex*>(base + footer->indexOffset);
+    for (uint64_t b = 0; b < footer->blockCount; b++) {
+        if (index[b].count > COLUMNAR_BLOCK_SIZE) {
+            std::cerr << "invalid columnar trace block index " << path << std::endl;
+            munmap(map, st.st_size);
+            return;
+        }
+    }
+    _map = base;
+    _mapLength = st.st_size;
+    _index = index;
+    _blockCount = footer->blockCount;
+    _count = footer->count;
+}
+
+ColumnarTraceReader::~ColumnarTraceReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _slotFree.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    if (_map != nullptr) {
+        munmap(const_cast<char*>(_map), _mapLength);
+    }
+}
+
+bool ColumnarTraceReader::decodeBlock(uint64_t block, std::vector<TraceRecord>& recs) const
+{
+    const ColumnarBlockIndex& idx = _index[block];
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        if (idx.offset[c] > _mapLength || idx.length[c] > _mapLength - idx.offset[c]) {
+            return false;
+        }
+    }
+    recs.resize(idx.count);
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t v, prev;
+
+    // the time column is skipped when nobody needs it
+    if (_decodeTimes) {
+        p = reinterpret_cast<const uint8_t*>(_map + idx.offset[COLUMN_TIME]);
+        end = p + idx.length[COLUMN_TIME];
+        prev = 0;
+        for (uint64_t i = 0; i < idx.count; i++) {
+            if ((p = getVarint(p, end, v)) == nullptr) {
+                return false;
+            }
+            prev += unzigzag(v);
+            recs[i].t = prev;
+        }
+    } else {
+        for (uint64_t i = 0; i < idx.count; i++) {
+            recs[i].t = 0;
+        }
+    }
+
+    p = reinterpret_cast<const uint8_t*>(_map + idx.offset[COLUMN_ID]);
+    end = p + idx.length[COLUMN_ID];
+    for (uint64_t i = 0; i < idx.count; i++) {
+        if ((p = getVarint(p, end, recs[i].id)) == nullptr) {
+            return false;
+        }
+    }
+
+    p = reinterpret_cast<const uint8_t*>(_map + idx.offset[COLUMN_SIZE]);
+    end = p + idx.length[COLUMN_SIZE];
+    prev = 0;
+    for (uint64_t i = 0; i < idx.count; i++) {
+        if ((p = getVarint(p, end, v)) == nullptr) {
+            return false;
+        }
+        prev += unzigzag(v);
+        recs[i].size = prev;
+    }
+    return true;
+}
+
+void ColumnarTraceReader::start()
+{
+    // two blocks per worker keep the workers busy while one is consumed
+    _ring.resize(2 * _threads);
+    for (uint64_t b = _current; b < _current + _ring.size(); b++) {
+        _ring[b % _ring.size()].index = b;
+        _ring[b % _ring.size()].ready = false;
+    }
+    _nextClaim = _current;
+    for (unsigned int i = 0; i < _threads; i++) {
+        _workers.push_back(std::thread(&ColumnarTraceReader::run, this));
+    }
+}
+
+void ColumnarTraceReader::run()
+{
+    while (true) {
+        const uint64_t b = _nextClaim++;
+        if (b >= _blockCount) {
+            return;
+        }
+        Block& block = _ring[b % _ring.size()];
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _slotFree.wait(lock, [&] { return block.index == b || _stop; });
+            if (_stop) {
+                return;
+            }
+        }
+        block.ok = decodeBlock(b, block.recs);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            block.ready = true;
+        }
+        _blockReady.notify_one();
+    }
+}
+
+size_t ColumnarTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    if (_threads > 1 && _workers.empty() && _current < _blockCount) {
+        start();
+    }
+    while (_good && _current < _blockCount) {
+        Block& block = _ring[_current % _ring.size()];
+        if (_workers.empty()) {
+            if (!block.ready) {
+                block.ok = decodeBlock(_current, block.recs);
+                block.ready = true;
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _blockReady.wait(lock, [&] { return block.ready; });
+        }
+        if (!block.ok) {
+            std::cerr << "corrupt columnar trace block " << _current << std::endl;
+            _good = false;
+            break;
+        }
+        if (_pos < block.recs.size()) {
+            const size_t n = std::min(TRACE_BATCH_SIZE, block.recs.size() - _pos);
+            batch = block.recs.data() + _pos;
+            _pos += n;
+            return n;
+        }
+        // block consumed, reserve its slot for a later block
+        _current++;
+        _pos = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            block.ready = false;
+            block.index += _ring.size();
+        }
+        _slotFree.notify_all();
+    }
+    return 0;
+}
+
+uint64_t ColumnarTraceReader::seekRequest(uint64_t request)
+{
+    if (!_workers.empty()) {
+        return 0;
+    }
+    // continue at the block containing request
+    const ColumnarBlockIndex* block =
+        std::upper_bound(_index, _index + _blockCount, request,
+                         [](uint64_t r, const ColumnarBlockIndex& b) { return r < b.firstRecord; });
+    _current = (block == _index) ? 0 : block - 1 - _index;
+    _pos = 0;
+    _ring[0].ready = false;
+    return _current < _blockCount ? _index[_current].firstRecord : 0;
+}
+
+uint64_t ColumnarTraceReader::seekTime(uint64_t t)
+{
+    if (!_workers.empty()) {
+        return 0;
+    }
+    // the block before the first block starting at or after t
+    const ColumnarBlockIndex* block =
+        std::lower_bound(_index, _index + _blockCount, t,
+                         [](const ColumnarBlockIndex& b, uint64_t v) { return b.firstTime < v; });
+    _current = (block == _index) ? 0 : block - 1 - _index;
+    _pos = 0;
+    _ring[0].ready = false;
+    return _current < _blockCount ? _index[_current].firstRecord : 0;
+}
+
+/*
+  ColumnarTraceWriter
+*/
+ColumnarTraceWriter::ColumnarTraceWriter()
+    : _outfile(NULL),
+      _offset(0),
+      _count(0)
+{
+}
+
+ColumnarTraceWriter::~ColumnarTraceWriter()
+{
+    if (_outfile != NULL) {
+        close();
+    }
+}
+
+bool ColumnarTraceWriter::open(const std::string& path)
+{
+    _outfile = fopen(path.c_str(), "wb");
+    if (_outfile == NULL) {
+        std::cerr << "cannot open output " << path << std::endl;
+        return false;
+    }
+    _count = 0;
+    _index.clear();
+    _block.reserve(COLUMNAR_BLOCK_SIZE);
+    ColumnarTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COLUMNAR_TRACE_MAGIC, sizeof(COLUMNAR_TRACE_MAGIC));
+    header.version = COLUMNAR_TRACE_VERSION;
+    header.blockSize = COLUMNAR_BLOCK_SIZE;
+    _offset = sizeof(header);
+    return fwrite(&header, sizeof(header), 1, _outfile) == 1;
+}
+
+bool ColumnarTraceWriter::writeBlock()
+{
+    if (_block.empty()) {
+        return true;
+    }
+    std::vector<uint8_t> columns[COLUMN_COUNT];
+    uint64_t prevTime = 0, prevSize = 0;
+    for (const TraceRecord& rec : _block) {
+        putVarint(columns[COLUMN_TIME], zigzag(rec.t - prevTime));
+        putVarint(columns[COLUMN_ID], rec.id);
+        putVarint(columns[COLUMN_SIZE], zigzag(rec.size - prevSize));
+        prevTime = rec.t;
+        prevSize = rec.size;
+    }
+    ColumnarBlockIndex idx;
+    idx.firstRecord = _count;
+    idx.count = _block.size();
+    idx.firstTime = _block.front().t;
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+        idx.offset[c] = _offset;
+        idx.length[c] = columns[c].size();
+        if (fwrite(columns[c].data(), 1, columns[c].size(), _outfile) != columns[c].size()) {
+            return false;
+        }
+        _offset += columns[c].size();
+    }
+    _index.push_back(idx);
+    _count += _block.size();
+    _block.clear();
+    return true;
+}
+
+bool ColumnarTraceWriter::close()
+{
+    bool ok = writeBlock();
+    // align the block index
+    const char padding[8] = {0};
+    const size_t padLength = (8 - _offset % 8) % 8;
+    ok = ok && fwrite(padding, 1, padLength, _outfile) == padLength;
+    _offset += padLength;
+    ColumnarTraceFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.indexOffset = _offset;
+    footer.blockCount = _index.size();
+    footer.count = _count;
+    memcpy(footer.magic, COLUMNAR_TRACE_MAGIC, sizeof(COLUMNAR_TRACE_MAGIC));
+    ok = ok && fwrite(_index.data(), sizeof(ColumnarBlockIndex), _index.size(), _outfile) == _index.size()
+        && fwrite(&footer, sizeof(footer), 1, _outfile) == 1;
+    ok = (fclose(_outfile) == 0) && ok;
+    _outfile = NULL;
+    return ok;
+}
@@ -0,0 +1,146 @@
+#ifndef COLUMNAR_TRACE_H
+#define COLUMNAR_TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "traces/trace_reader.h"
+
+/*
+  Columnar trace format
+
+  header, then blocks of up to blockSize requests, then the block index
+  and a footer. Each block stores the time, id and size columns one after
+  another: times and sizes as zigzag varints of the delta to the previous
+  request, ids as plain varints. Deltas restart in every block, so blocks
+  can be decoded independently.
+*/
+const char COLUMNAR_TRACE_MAGIC[8] = {'W', 'C', 'S', 'C', 'O', 'L', 'T', 'R'};
+const uint32_t COLUMNAR_TRACE_VERSION = 1;
+const uint32_t COLUMNAR_BLOCK_SIZE = 1 << 16;
+
+enum ColumnarColumn { COLUMN_TIME = 0, COLUMN_ID = 1, COLUMN_SIZE = 2, COLUMN_COUNT = 3 };
+
+struct ColumnarTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize; // requests per block
+};
+
+struct ColumnarBlockIndex
+{
+    uint64_t firstRecord; // number of the first request in this block
+    uint64_t count; // requests in this block
+    uint64_t firstTime; // time of the first request
+    uint64_t offset[COLUMN_COUNT]; // file offset of each column
+    uint64_t length[COLUMN_COUNT]; // encoded length of each column
+};
+
+struct ColumnarTraceFooter
+{
+    uint64_t indexOffset; // file offset of the block index
+    uint64_t blockCount;
+    uint64_t count; // number of requests
+    char magic[8];
+};
+
+bool isColumnarTrace(const std::string& path);
+
+/*
+  ColumnarTraceReader: memory-maps a columnar trace and decodes blocks in parallel
+
+  with more than one thread, worker threads decode blocks into a ring of
+  slots ahead of nextBatch, which hands them out in order. With one
+  thread, blocks are decoded on the caller's thread.
+*/
+class ColumnarTraceReader : public TraceReader
+{
+protected:
+    struct Block {
+        uint64_t index; // block this slot is reserved for
+        bool ready; // decoded and not yet consumed
+        bool ok; // false if the block is corrupt
+        std::vector<TraceRecord> recs;
+    };
+
+    const char* _map; // mapped file
+    size_t _mapLength;
+    const ColumnarBlockIndex* _index;
+    uint64_t _blockCount;
+    uint64_t _count;
+    bool _decodeTimes;
+    bool _good;
+    unsigned int _threads; // blocks decoded concurrently
+    std::vector<Block> _ring;
+    std::vector<std::thread> _workers;
+    std::atomic<uint64_t> _nextClaim; // next block claimed by a worker
+    uint64_t _current; // block handed out by nextBatch
+    size_t _pos; // position in the current block
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _blockReady;
+    std::condition_variable _slotFree;
+
+    // decode one block into recs, false if the block is corrupt
+    bool decodeBlock(uint64_t block, std::vector<TraceRecord>& recs) const;
+    // workers are started on the first nextBatch call, after any seek
+    void start();
+    void run();
+
+public:
+    ColumnarTraceReader(const std::string& path, unsigned int threads);
+    virtual ~ColumnarTraceReader();
+
+    bool isOpen() const {
+        return _map != nullptr;
+    }
+    uint64_t count() const {
+        return _count;
+    }
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual void setDecodeTimes(bool decode) {
+        _decodeTimes = decode;
+    }
+    virtual bool good() const {
+        return _good;
+    }
+    virtual uint64_t seekRequest(uint64_t request);
+    virtual uint64_t seekTime(uint64_t t);
+};
+
+/*
+  ColumnarTraceWriter: encodes requests block by block
+*/
+class ColumnarTraceWriter
+{
+protected:
+    FILE* _outfile;
+    uint64_t _offset; // current file offset
+    std::vector<TraceRecord> _block;
+    std::vector<ColumnarBlockIndex> _index;
+    uint64_t _count;
+
+    bool writeBlock();
+
+public:
+    ColumnarTraceWriter();
+    ~ColumnarTraceWriter();
+
+    bool open(const std::string& path);
+    bool write(const TraceRecord& rec) {
+        _block.push_back(rec);
+        if (_block.size() >= COLUMNAR_BLOCK_SIZE) {
+            return writeBlock();
+        }
+        return true;
+    }
+    // write the last block, the block index and the footer
+    bool close();
+};
+
+#endif /* COLUMNAR_TRACE_H */
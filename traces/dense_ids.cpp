@@ -0,0 +1,173 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dense_ids.h"
+#include "id_assigner.h"
+
+std::string denseIdsPath(const std::string& tracePath)
+{
+    return tracePath + ".ids";
+}
+
+bool buildDenseIds(const std::string& tracePath, unsigned int threads)
+{
+    DenseIdsHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!traceStamp(tracePath, header.traceSize, header.traceMtime)) {
+        std::cerr << "cannot stat trace " << tracePath << std::endl;
+        return false;
+    }
+    std::unique_ptr<TraceReader> trace = TraceReader::create_unique(tracePath, threads);
+    if (trace == nullptr) {
+        return false;
+    }
+    trace->setDecodeTimes(false);
+
+    // write to a temporary file, so an interrupted pass leaves no stale mapping
+    const std::string path = denseIdsPath(tracePath);
+    const std::string tmpPath = path + ".tmp";
+    FILE* outfile = fopen(tmpPath.c_str(), "wb");
+    if (outfile == NULL) {
+        std::cerr << "cannot open output " << tmpPath << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, outfile) == 1;
+
+    IdAssigner denseIds(1 << 20);
+    std::vector<uint32_t> buffer(TRACE_BATCH_SIZE);
+    const TraceRecord* batch;
+    size_t n;
+    while (ok && (n = trace->nextBatch(batch)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            buffer[i] = denseIds.assign(batch[i].id);
+        }
+        if (denseIds.size() > UINT32_MAX) {
+            std::cerr << "too many distinct ids for a dense id mapping" << std::endl;
+            ok = false;
+        }
+        ok = ok && fwrite(buffer.data(), sizeof(uint32_t), n, outfile) == n;
+        header.count += n;
+    }
+    ok = ok && trace->good();
+
+    memcpy(header.magic, DENSE_IDS_MAGIC, sizeof(DENSE_IDS_MAGIC));
+    header.version = DENSE_IDS_VERSION;
+    header.idSize = sizeof(uint32_t);
+    header.objects = denseIds.size();
+    ok = ok && fseek(outfile, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, outfile) == 1;
+    ok = (fclose(outfile) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "cannot write dense id mapping " << path << std::endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    std::cerr << "dense id mapping: " << header.count << " requests, "
+              << header.objects << " objects" << std::endl;
+    return true;
+}
+
+/*
+  DenseIdReader
+*/
+DenseIdReader::DenseIdReader(std::unique_ptr<TraceReader> trace, const std::string& tracePath)
+    : TraceReader(),
+      _trace(std::move(trace)),
+      _map(nullptr),
+      _mapLength(0),
+      _ids(nullptr),
+      _count(0),
+      _objects(0),
+      _pos(0),
+      _good(true),
+      _batch(TRACE_BATCH_SIZE)
+{
+    uint64_t traceSize, traceMtime;
+    const int fd = open(denseIdsPath(tracePath).c_str(), O_RDONLY);
+    if (fd < 0 || !traceStamp(tracePath, traceSize, traceMtime)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(DenseIdsHeader)) {
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    const DenseIdsHeader* header = static_cast<const DenseIdsHeader*>(map);
+    if (memcmp(header->magic, DENSE_IDS_MAGIC, sizeof(DENSE_IDS_MAGIC)) != 0
+        || header->version != DENSE_IDS_VERSION
+        || header->idSize != sizeof(uint32_t)
+        || header->traceSize != traceSize
+        || header->traceMtime != traceMtime
+        || header->count > (st.st_size - sizeof(DenseIdsHeader)) / sizeof(uint32_t)) {
+        // stale or foreign mapping
+        munmap(map, st.st_size);
+        return;
+    }
+    _map = static_cast<const char*>(map);
+    _mapLength = st.st_size;
+    _ids = reinterpret_cast<const uint32_t*>(_map + sizeof(DenseIdsHeader));
+    _count = header->count;
+    _objects = header->objects;
+}
+
+std::unique_ptr<DenseIdReader> DenseIdReader::create_unique(const std::string& tracePath,
+                                                            unsigned int threads)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        std::unique_ptr<TraceReader> trace = TraceReader::create_unique(tracePath, threads);
+        if (trace == nullptr) {
+            return nullptr;
+        }
+        std::unique_ptr<DenseIdReader> reader(new DenseIdReader(std::move(trace), tracePath));
+        if (reader->isOpen()) {
+            return reader;
+        }
+        if (attempt == 0) {
+            std::cerr << "building dense id mapping " << denseIdsPath(tracePath) << std::endl;
+            if (!buildDenseIds(tracePath, threads)) {
+                return nullptr;
+            }
+        }
+    }
+    std::cerr << "cannot read dense id mapping " << denseIdsPath(tracePath) << std::endl;
+    return nullptr;
+}
+
+DenseIdReader::~DenseIdReader()
+{
+    if (_map != nullptr) {
+        munmap(const_cast<char*>(_map), _mapLength);
+    }
+}
+
+size_t DenseIdReader::nextBatch(const TraceRecord*& batch)
+{
+    const TraceRecord* recs;
+    const size_t n = _good ? _trace->nextBatch(recs) : 0;
+    if (n > _count - _pos) {
+        std::cerr << "dense id mapping does not match the trace" << std::endl;
+        _good = false;
+        return 0;
+    }
+    _batch.resize(std::max(_batch.size(), n));
+    for (size_t i = 0; i < n; i++) {
+        _batch[i].t = recs[i].t;
+        _batch[i].id = _ids[_pos + i];
+        _batch[i].size = recs[i].size;
+    }
+    _pos += n;
+    batch = _batch.data();
+    return n;
+}
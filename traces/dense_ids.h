@@ -0,0 +1,88 @@
+#ifndef DENSE_IDS_H
+#define DENSE_IDS_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "traces/trace_reader.h"
+
+/*
+  Dense id mapping
+
+  a sidecar file next to the trace (trace path + ".ids") stores, for every
+  request in trace order, the object id remapped to a dense id in
+  [0, objects), in the order objects first appear in the trace.
+  The trace's size and modification time detect stale mappings.
+*/
+const char DENSE_IDS_MAGIC[8] = {'W', 'C', 'S', 'I', 'D', 'M', 'A', 'P'};
+const uint32_t DENSE_IDS_VERSION = 1;
+
+struct DenseIdsHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t idSize; // bytes per dense id
+    uint64_t traceSize; // size of the trace file
+    uint64_t traceMtime; // modification time of the trace file (ns)
+    uint64_t count; // number of requests
+    uint64_t objects; // number of distinct ids
+};
+
+// path of the sidecar file of a trace
+std::string denseIdsPath(const std::string& tracePath);
+
+// build the sidecar file of a trace in one pass, false on errors
+bool buildDenseIds(const std::string& tracePath, unsigned int threads);
+
+/*
+  DenseIdReader: replaces the ids of another TraceReader with dense ids from the sidecar file
+*/
+class DenseIdReader : public TraceReader
+{
+protected:
+    std::unique_ptr<TraceReader> _trace;
+    const char* _map; // mapped sidecar file
+    size_t _mapLength;
+    const uint32_t* _ids;
+    uint64_t _count;
+    uint64_t _objects;
+    uint64_t _pos;
+    bool _good;
+    std::vector<TraceRecord> _batch;
+
+public:
+    DenseIdReader(std::unique_ptr<TraceReader> trace, const std::string& tracePath);
+    virtual ~DenseIdReader();
+
+    // open a trace with dense ids, the sidecar file is built first if it is missing or stale
+    static std::unique_ptr<DenseIdReader> create_unique(const std::string& tracePath,
+                                                        unsigned int threads = 1);
+
+    // false if the sidecar file is missing or does not match the trace
+    bool isOpen() const {
+        return _map != nullptr;
+    }
+    // number of distinct objects ids
+    uint64_t objects() const {
+        return _objects;
+    }
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual void setDecodeTimes(bool decode) {
+        _trace->setDecodeTimes(decode);
+    }
+    virtual bool good() const {
+        return _good && _trace->good();
+    }
+    virtual uint64_t seekRequest(uint64_t request) {
+        _pos = std::min(_trace->seekRequest(request), _count);
+        return _pos;
+    }
+    virtual uint64_t seekTime(uint64_t t) {
+        _pos = std::min(_trace->seekTime(t), _count);
+        return _pos;
+    }
+};
+
+#endif /* DENSE_IDS_H */
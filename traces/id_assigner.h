@@ -0,0 +1,77 @@
+#ifndef ID_ASSIGNER_H
+#define ID_ASSIGNER_H
+
+#include <cstdint>
+#include <vector>
+#include "hash.h"
+
+/*
+  IdAssigner: assigns dense ids 0, 1, 2, ... to 64-bit keys in order of first appearance
+
+  open addressing with linear probing over flat arrays
+*/
+class IdAssigner
+{
+protected:
+    std::vector<uint64_t> _keys;
+    std::vector<uint64_t> _ids; // dense id + 1, 0 marks an empty slot
+    uint64_t _mask;
+    uint64_t _size;
+
+    void grow() {
+        std::vector<uint64_t> keys(2 * _keys.size());
+        std::vector<uint64_t> ids(2 * _keys.size(), 0);
+        const uint64_t mask = keys.size() - 1;
+        for (size_t i = 0; i < _keys.size(); i++) {
+            if (_ids[i] != 0) {
+                uint64_t slot = mix64(_keys[i]) & mask;
+                while (ids[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                keys[slot] = _keys[i];
+                ids[slot] = _ids[i];
+            }
+        }
+        _keys.swap(keys);
+        _ids.swap(ids);
+        _mask = mask;
+    }
+
+public:
+    IdAssigner(uint64_t expected = 1 << 16)
+        : _size(0)
+    {
+        uint64_t capacity = 16;
+        while (capacity < 2 * expected) {
+            capacity *= 2;
+        }
+        _keys.resize(capacity);
+        _ids.resize(capacity, 0);
+        _mask = capacity - 1;
+    }
+
+    // dense id of key, a new id is assigned on its first appearance
+    uint64_t assign(uint64_t key) {
+        uint64_t slot = mix64(key) & _mask;
+        while (_ids[slot] != 0) {
+            if (_keys[slot] == key) {
+                return _ids[slot] - 1;
+            }
+            slot = (slot + 1) & _mask;
+        }
+        _keys[slot] = key;
+        _ids[slot] = ++_size;
+        // keep the load factor below 0.7
+        if (10 * _size > 7 * _keys.size()) {
+            grow();
+        }
+        return _size - 1;
+    }
+
+    // number of assigned ids
+    uint64_t size() const {
+        return _size;
+    }
+};
+
+#endif /* ID_ASSIGNER_H */
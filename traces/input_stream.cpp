@@ -0,0 +1,297 @@
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "input_stream.h"
+
+// size of the blocks passed between decompression and parsing
+const size_t PIPELINE_BLOCK_SIZE = 1 << 20;
+// number of decompressed blocks buffered ahead of the parser
+const size_t PIPELINE_RING_SIZE = 8;
+
+enum CompressionType { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD };
+
+static CompressionType detectCompression(const std::string& path)
+{
+    unsigned char magic[4] = {0, 0, 0, 0};
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return COMPRESSION_NONE;
+    }
+    const size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return COMPRESSION_GZIP;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+bool isCompressed(const std::string& path)
+{
+    return detectCompression(path) != COMPRESSION_NONE;
+}
+
+std::unique_ptr<InputStream> InputStream::create_unique(const std::string& path)
+{
+    switch (detectCompression(path)) {
+    case COMPRESSION_GZIP: {
+        std::unique_ptr<GzipInput> input(new GzipInput(path));
+        if (!input->isOpen()) {
+            return nullptr;
+        }
+        return std::unique_ptr<InputStream>(new PipelinedInput(std::move(input)));
+    }
+    case COMPRESSION_ZSTD: {
+#ifdef USE_ZSTD
+        std::unique_ptr<ZstdInput> input(new ZstdInput(path));
+        if (!input->isOpen()) {
+            return nullptr;
+        }
+        return std::unique_ptr<InputStream>(new PipelinedInput(std::move(input)));
+#else
+        std::cerr << "zstd support not compiled in (make ZSTD=1): " << path << std::endl;
+        return nullptr;
+#endif
+    }
+    default: {
+        std::unique_ptr<FileInput> input(new FileInput(path));
+        if (!input->isOpen()) {
+            return nullptr;
+        }
+        return std::move(input);
+    }
+    }
+}
+
+/*
+  FileInput
+*/
+FileInput::FileInput(const std::string& path)
+    : InputStream(),
+      _path(path),
+      _fd(open(path.c_str(), O_RDONLY))
+{
+    if (_fd < 0) {
+        std::cerr << "cannot open trace " << path << std::endl;
+        return;
+    }
+    posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+FileInput::~FileInput()
+{
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+ssize_t FileInput::read(char* buf, size_t len)
+{
+    ssize_t r;
+    do {
+        r = ::read(_fd, buf, len);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0) {
+        std::cerr << "read error " << _path << ": " << strerror(errno) << std::endl;
+    }
+    return r;
+}
+
+bool FileInput::seek(uint64_t offset)
+{
+    return lseek(_fd, offset, SEEK_SET) == off_t(offset);
+}
+
+/*
+  GzipInput
+*/
+GzipInput::GzipInput(const std::string& path)
+    : InputStream(),
+      _path(path),
+      _gz(gzopen(path.c_str(), "rb"))
+{
+    if (_gz == NULL) {
+        std::cerr << "cannot open trace " << path << std::endl;
+        return;
+    }
+    gzbuffer(_gz, 1 << 18);
+}
+
+GzipInput::~GzipInput()
+{
+    if (_gz != NULL) {
+        gzclose(_gz);
+    }
+}
+
+ssize_t GzipInput::read(char* buf, size_t len)
+{
+    const int r = gzread(_gz, buf, static_cast<unsigned>(std::min<size_t>(len, INT_MAX)));
+    int err = Z_OK;
+    const char* msg = gzerror(_gz, &err);
+    // a truncated file ends with Z_BUF_ERROR instead of a read error
+    if (r < 0 || (r == 0 && err != Z_OK)) {
+        std::cerr << "gzip error " << _path << ": " << msg << std::endl;
+        return -1;
+    }
+    return r;
+}
+
+#ifdef USE_ZSTD
+/*
+  ZstdInput
+*/
+ZstdInput::ZstdInput(const std::string& path)
+    : InputStream(),
+      _file(path),
+      _stream(ZSTD_createDStream()),
+      _in(ZSTD_DStreamInSize()),
+      _eof(false),
+      _lastRet(0)
+{
+    _inBuf.src = _in.data();
+    _inBuf.size = 0;
+    _inBuf.pos = 0;
+    if (_stream != NULL) {
+        ZSTD_initDStream(_stream);
+    }
+}
+
+ZstdInput::~ZstdInput()
+{
+    if (_stream != NULL) {
+        ZSTD_freeDStream(_stream);
+    }
+}
+
+ssize_t ZstdInput::read(char* buf, size_t len)
+{
+    ZSTD_outBuffer out = {buf, len, 0};
+    while (out.pos == 0) {
+        if (_inBuf.pos == _inBuf.size && !_eof) {
+            const ssize_t r = _file.read(_in.data(), _in.size());
+            if (r < 0) {
+                return -1;
+            }
+            _eof = (r == 0);
+            _inBuf.size = r;
+            _inBuf.pos = 0;
+        }
+        // with empty input this flushes data buffered in the decoder
+        const size_t inPos = _inBuf.pos;
+        const size_t ret = ZSTD_decompressStream(_stream, &out, &_inBuf);
+        if (ZSTD_isError(ret)) {
+            std::cerr << "zstd error: " << ZSTD_getErrorName(ret) << std::endl;
+            return -1;
+        }
+        if (_inBuf.pos != inPos || out.pos > 0) {
+            // ret is 0 once a frame is completely decoded and flushed
+            _lastRet = ret;
+        }
+        if (out.pos == 0 && _eof && _inBuf.pos == _inBuf.size) {
+            if (_lastRet != 0) {
+                std::cerr << "truncated zstd trace" << std::endl;
+                return -1;
+            }
+            break;
+        }
+    }
+    return out.pos;
+}
+#endif
+
+/*
+  PipelinedInput
+*/
+PipelinedInput::PipelinedInput(std::unique_ptr<InputStream> source)
+    : InputStream(),
+      _source(std::move(source)),
+      _ring(PIPELINE_RING_SIZE),
+      _head(0),
+      _headPos(0),
+      _tail(0),
+      _filled(0),
+      _done(false),
+      _error(false),
+      _stop(false)
+{
+    for (auto& block : _ring) {
+        block.data.resize(PIPELINE_BLOCK_SIZE);
+        block.size = 0;
+    }
+    _thread = std::thread(&PipelinedInput::run, this);
+}
+
+PipelinedInput::~PipelinedInput()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _notFull.notify_one();
+    _thread.join();
+}
+
+void PipelinedInput::run()
+{
+    while (true) {
+        Block* block;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this] { return _filled < _ring.size() || _stop; });
+            if (_stop) {
+                return;
+            }
+            block = &_ring[_tail];
+        }
+        // fill the whole block so the consumer sees few, large blocks
+        size_t size = 0;
+        ssize_t r = 1;
+        while (size < block->data.size()
+               && (r = _source->read(block->data.data() + size, block->data.size() - size)) > 0) {
+            size += r;
+        }
+        block->size = size;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (size > 0) {
+                _tail = (_tail + 1) % _ring.size();
+                _filled++;
+            }
+            _done = (r <= 0);
+            _error = (r < 0);
+        }
+        _notEmpty.notify_one();
+        if (r <= 0) {
+            return;
+        }
+    }
+}
+
+ssize_t PipelinedInput::read(char* buf, size_t len)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_filled > 0 && _headPos == _ring[_head].size) {
+        // hand the consumed block back to the source thread
+        _head = (_head + 1) % _ring.size();
+        _headPos = 0;
+        _filled--;
+        _notFull.notify_one();
+    }
+    _notEmpty.wait(lock, [this] { return _filled > 0 || _done; });
+    if (_filled == 0) {
+        return _error ? -1 : 0;
+    }
+    const Block& block = _ring[_head];
+    lock.unlock();
+    // the head block is not touched by the source thread until released
+    const size_t n = std::min(len, block.size - _headPos);
+    memcpy(buf, block.data.data() + _headPos, n);
+    _headPos += n;
+    return n;
+}
@@ -0,0 +1,147 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include <zlib.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+/*
+  InputStream: sequential byte source for text traces
+
+  plain, gzip and zstd compressed files are detected from their magic bytes
+*/
+class InputStream
+{
+public:
+    InputStream() {}
+    virtual ~InputStream() {}
+
+    // read up to len bytes into buf, returns the number of bytes read,
+    // 0 at the end of the stream and -1 on errors
+    virtual ssize_t read(char* buf, size_t len) = 0;
+
+    // continue reading at byte offset of the file, false if the stream cannot seek
+    virtual bool seek(uint64_t offset) {
+        return false;
+    }
+
+    // open a file, compressed files are decompressed on a separate thread
+    static std::unique_ptr<InputStream> create_unique(const std::string& path);
+};
+
+// true if a file is gzip or zstd compressed
+bool isCompressed(const std::string& path);
+
+/*
+  FileInput: uncompressed file
+*/
+class FileInput : public InputStream
+{
+protected:
+    std::string _path;
+    int _fd;
+
+public:
+    FileInput(const std::string& path);
+    virtual ~FileInput();
+
+    bool isOpen() const {
+        return _fd >= 0;
+    }
+
+    virtual ssize_t read(char* buf, size_t len);
+    virtual bool seek(uint64_t offset);
+};
+
+/*
+  GzipInput: gzip compressed file (via zlib)
+*/
+class GzipInput : public InputStream
+{
+protected:
+    std::string _path;
+    gzFile _gz;
+
+public:
+    GzipInput(const std::string& path);
+    virtual ~GzipInput();
+
+    bool isOpen() const {
+        return _gz != NULL;
+    }
+
+    virtual ssize_t read(char* buf, size_t len);
+};
+
+#ifdef USE_ZSTD
+/*
+  ZstdInput: zstd compressed file
+*/
+class ZstdInput : public InputStream
+{
+protected:
+    FileInput _file;
+    ZSTD_DStream* _stream;
+    std::vector<char> _in;
+    ZSTD_inBuffer _inBuf;
+    bool _eof; // no more compressed input
+    size_t _lastRet; // 0 if the last frame was complete
+
+public:
+    ZstdInput(const std::string& path);
+    virtual ~ZstdInput();
+
+    bool isOpen() const {
+        return _file.isOpen() && _stream != NULL;
+    }
+
+    virtual ssize_t read(char* buf, size_t len);
+};
+#endif
+
+/*
+  PipelinedInput: reads another InputStream ahead on a background thread
+
+  the source (e.g., a decompressor) fills a ring of blocks while the caller
+  parses the previous ones
+*/
+class PipelinedInput : public InputStream
+{
+protected:
+    struct Block {
+        std::vector<char> data;
+        size_t size;
+    };
+
+    std::unique_ptr<InputStream> _source;
+    std::vector<Block> _ring;
+    size_t _head; // block read by the consumer
+    size_t _headPos; // consumer position in the head block
+    size_t _tail; // next block filled by the source thread
+    size_t _filled; // number of filled blocks in the ring
+    bool _done; // source reached the end of the stream
+    bool _error; // source failed
+    bool _stop; // consumer shuts down the source thread
+    std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::thread _thread;
+
+    void run();
+
+public:
+    PipelinedInput(std::unique_ptr<InputStream> source);
+    virtual ~PipelinedInput();
+
+    virtual ssize_t read(char* buf, size_t len);
+};
+
+#endif /* INPUT_STREAM_H */
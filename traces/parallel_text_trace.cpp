@@ -0,0 +1,221 @@
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parallel_text_trace.h"
+#include "text_parse.h"
+#include "trace_index.h"
+
+ParallelTextTraceReader::ParallelTextTraceReader(const std::string& path, unsigned int threads,
+                                                 const LineParser* parser)
+    : TraceReader(),
+      _path(path),
+      _parser(parser),
+      _map(nullptr),
+      _mapLength(0),
+      _threads(threads > 0 ? threads : 1),
+      _nextChunk(0),
+      _current(0),
+      _pos(0),
+      _linesBefore(0),
+      _good(true),
+      _stop(false)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "cannot open trace " << path << std::endl;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "cannot read trace " << path << std::endl;
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "cannot mmap trace " << path << std::endl;
+        return;
+    }
+    _map = static_cast<const char*>(map);
+    _mapLength = st.st_size;
+    split(0);
+}
+
+void ParallelTextTraceReader::split(size_t start)
+{
+    // split at the first newline after every PARALLEL_CHUNK_SIZE bytes
+    _bounds.assign(1, start);
+    while (_bounds.back() + PARALLEL_CHUNK_SIZE < _mapLength) {
+        const char* start = _map + _bounds.back() + PARALLEL_CHUNK_SIZE;
+        const char* eol = static_cast<const char*>(memchr(start, '\n', _map + _mapLength - start));
+        if (eol == nullptr) {
+            break;
+        }
+        _bounds.push_back(eol + 1 - _map);
+    }
+    if (_bounds.back() < _mapLength) {
+        _bounds.push_back(_mapLength);
+    }
+}
+
+void ParallelTextTraceReader::start()
+{
+    // two chunks per worker keep the workers busy while one is consumed
+    _ring.resize(2 * _threads);
+    for (size_t i = 0; i < _ring.size(); i++) {
+        _ring[i].index = i;
+        _ring[i].ready = false;
+    }
+    for (unsigned int i = 0; i < _threads; i++) {
+        _workers.push_back(std::thread(&ParallelTextTraceReader::run, this));
+    }
+}
+
+ParallelTextTraceReader::~ParallelTextTraceReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _slotFree.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    if (_map != nullptr) {
+        munmap(const_cast<char*>(_map), _mapLength);
+    }
+}
+
+void ParallelTextTraceReader::parseChunk(uint64_t k, Chunk& chunk) const
+{
+    const char* p = _map + _bounds[k];
+    const char* end = _map + _bounds[k + 1];
+    chunk.recs.clear();
+    chunk.lines = 0;
+    chunk.errorLine = 0;
+    TraceRecord rec;
+    // header lines are at the start of the first chunk (traces with a parser are not seeked)
+    const uint64_t headerLines = (k == 0 && _parser != nullptr) ? _parser->headerLines() : 0;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (eol == nullptr) {
+            eol = end;
+        }
+        chunk.lines++;
+        int parsed;
+        if (_parser == nullptr) {
+            parsed = parseTraceLine(p, eol, rec);
+        } else {
+            parsed = chunk.lines > headerLines ? _parser->parse(p, eol, rec) : 0;
+        }
+        if (parsed < 0) {
+            chunk.errorLine = chunk.lines;
+            break;
+        } else if (parsed > 0) {
+            chunk.recs.push_back(rec);
+        }
+        p = eol + 1;
+    }
+}
+
+void ParallelTextTraceReader::run()
+{
+    const uint64_t chunks = _bounds.size() - 1;
+    while (true) {
+        const uint64_t k = _nextChunk++;
+        if (k >= chunks) {
+            return;
+        }
+        Chunk& chunk = _ring[k % _ring.size()];
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _slotFree.wait(lock, [&] { return chunk.index == k || _stop; });
+            if (_stop) {
+                return;
+            }
+        }
+        parseChunk(k, chunk);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            chunk.ready = true;
+        }
+        _chunkReady.notify_one();
+    }
+}
+
+size_t ParallelTextTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    const uint64_t chunks = _bounds.size() - 1;
+    if (_workers.empty() && chunks > 0) {
+        start();
+    }
+    while (_good && _current < chunks) {
+        Chunk& chunk = _ring[_current % _ring.size()];
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _chunkReady.wait(lock, [&] { return chunk.ready; });
+        }
+        if (_pos < chunk.recs.size()) {
+            const size_t n = std::min(TRACE_BATCH_SIZE, chunk.recs.size() - _pos);
+            batch = chunk.recs.data() + _pos;
+            _pos += n;
+            return n;
+        }
+        if (chunk.errorLine > 0) {
+            // line numbers are only known once all earlier chunks are consumed
+            const uint64_t line = _linesBefore + chunk.errorLine;
+            const char* p = _map + _bounds[_current];
+            for (uint64_t l = 1; l < chunk.errorLine; l++) {
+                p = static_cast<const char*>(memchr(p, '\n', _map + _mapLength - p)) + 1;
+            }
+            const char* eol = static_cast<const char*>(memchr(p, '\n', _map + _mapLength - p));
+            std::cerr << _path << ":" << line << ": malformed trace line \""
+                      << std::string(p, eol != nullptr ? eol : _map + _mapLength) << "\"" << std::endl;
+            _good = false;
+            break;
+        }
+        // chunk consumed, reserve its slot for a later chunk
+        _linesBefore += chunk.lines;
+        _current++;
+        _pos = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            chunk.ready = false;
+            chunk.index += _ring.size();
+        }
+        _slotFree.notify_all();
+    }
+    return 0;
+}
+
+uint64_t ParallelTextTraceReader::seekRequest(uint64_t request)
+{
+    std::unique_ptr<TraceIndex> index;
+    if (_parser != nullptr || !_workers.empty() || !(index = TraceIndex::create_unique(_path))) {
+        return 0;
+    }
+    return seek(index->findRequest(request));
+}
+
+uint64_t ParallelTextTraceReader::seekTime(uint64_t t)
+{
+    std::unique_ptr<TraceIndex> index;
+    if (_parser != nullptr || !_workers.empty() || !(index = TraceIndex::create_unique(_path))) {
+        return 0;
+    }
+    return seek(index->findTime(t));
+}
+
+uint64_t ParallelTextTraceReader::seek(const TraceIndexEntry& entry)
+{
+    if (entry.offset > _mapLength) {
+        return 0;
+    }
+    split(entry.offset);
+    _linesBefore = entry.line;
+    return entry.request;
+}
@@ -0,0 +1,77 @@
+#ifndef PARALLEL_TEXT_TRACE_H
+#define PARALLEL_TEXT_TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "traces/trace_reader.h"
+
+// text traces are split into chunks of about this many bytes
+const size_t PARALLEL_CHUNK_SIZE = 1 << 23;
+// smaller traces are parsed by a single TextTraceReader
+const size_t PARALLEL_MIN_TRACE_SIZE = 4 * PARALLEL_CHUNK_SIZE;
+
+/*
+  ParallelTextTraceReader: parses an uncompressed text trace on several threads
+
+  the memory-mapped file is split into newline-aligned chunks, worker
+  threads parse chunks into a ring of record blocks, and nextBatch hands
+  the blocks out in their original order
+*/
+class ParallelTextTraceReader : public TraceReader
+{
+protected:
+    struct Chunk {
+        uint64_t index; // chunk this slot is reserved for
+        bool ready; // parsed and not yet consumed
+        std::vector<TraceRecord> recs;
+        uint64_t lines; // lines in the chunk
+        uint64_t errorLine; // line of the first malformed line in the chunk, 0 if none
+    };
+
+    std::string _path;
+    const LineParser* _parser; // nullptr for three column traces
+    const char* _map; // mapped file
+    size_t _mapLength;
+    std::vector<size_t> _bounds; // chunk k is [_bounds[k], _bounds[k+1])
+    unsigned int _threads;
+    std::vector<Chunk> _ring;
+    std::vector<std::thread> _workers;
+    std::atomic<uint64_t> _nextChunk; // next chunk claimed by a worker
+    uint64_t _current; // chunk handed out by nextBatch
+    size_t _pos; // position in the current chunk
+    uint64_t _linesBefore; // lines in all chunks before the current one
+    bool _good;
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _chunkReady;
+    std::condition_variable _slotFree;
+
+    // split [start, end of file) into chunks
+    void split(size_t start);
+    // workers are started on the first nextBatch call, after any seek
+    void start();
+    void run();
+    void parseChunk(uint64_t k, Chunk& chunk) const;
+    uint64_t seek(const TraceIndexEntry& entry);
+
+public:
+    ParallelTextTraceReader(const std::string& path, unsigned int threads,
+                            const LineParser* parser = nullptr);
+    virtual ~ParallelTextTraceReader();
+
+    bool isOpen() const {
+        return _map != nullptr;
+    }
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual bool good() const {
+        return _good;
+    }
+    virtual uint64_t seekRequest(uint64_t request);
+    virtual uint64_t seekTime(uint64_t t);
+};
+
+#endif /* PARALLEL_TEXT_TRACE_H */
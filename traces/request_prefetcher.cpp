@@ -0,0 +1,102 @@
+#include "request_prefetcher.h"
+
+RequestPrefetcher::RequestPrefetcher(std::unique_ptr<TraceReader> trace, size_t ringSize)
+    : _trace(std::move(trace)),
+      _ring(ringSize),
+      _head(0),
+      _tail(0),
+      _filled(0),
+      _held(0),
+      _done(false),
+      _stop(false)
+{
+    for (auto& batch : _ring) {
+        batch.times.resize(TRACE_BATCH_SIZE);
+        batch.reqs.resize(TRACE_BATCH_SIZE);
+        batch.size = 0;
+        batch.sampleRate = 1.0;
+    }
+    _thread = std::thread(&RequestPrefetcher::run, this);
+}
+
+RequestPrefetcher::~RequestPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _notFull.notify_one();
+    _thread.join();
+}
+
+void RequestPrefetcher::run()
+{
+    while (true) {
+        RequestBatch* batch;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this] { return _filled < _ring.size() || _stop; });
+            if (_stop) {
+                return;
+            }
+            batch = &_ring[_tail];
+        }
+        // decode outside the lock, the slot is not visible to the consumer yet
+        const TraceRecord* records;
+        const size_t n = _trace->nextBatch(records);
+        for (size_t i = 0; i < n; i++) {
+            batch->times[i] = records[i].t;
+            batch->reqs[i].reinit(records[i].id, records[i].size);
+        }
+        batch->size = n;
+        batch->sampleRate = _trace->sampleRate();
+        const TraceRecord* dropped;
+        batch->dropped.resize(_trace->droppedObjects(dropped));
+        for (size_t i = 0; i < batch->dropped.size(); i++) {
+            batch->dropped[i].reinit(dropped[i].id, dropped[i].size);
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (n == 0) {
+                _done = true;
+            } else {
+                _tail = (_tail + 1) % _ring.size();
+                _filled++;
+            }
+        }
+        _notEmpty.notify_one();
+        if (n == 0) {
+            return;
+        }
+    }
+}
+
+RequestBatch* RequestPrefetcher::next()
+{
+    if (_held > 0) {
+        release();
+    }
+    return acquire();
+}
+
+RequestBatch* RequestPrefetcher::acquire()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] { return _filled > _held || _done; });
+    if (_filled == _held) {
+        return nullptr;
+    }
+    return &_ring[(_head + _held++) % _ring.size()];
+}
+
+void RequestPrefetcher::release()
+{
+    {
+        // hand the batch back to the reader thread
+        std::lock_guard<std::mutex> lock(_mutex);
+        _head = (_head + 1) % _ring.size();
+        _filled--;
+        _held--;
+    }
+    _notFull.notify_one();
+}
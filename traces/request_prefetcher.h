@@ -0,0 +1,74 @@
+#ifndef REQUEST_PREFETCHER_H
+#define REQUEST_PREFETCHER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "request.h"
+#include "traces/trace_reader.h"
+
+// number of batches decoded ahead of the simulation
+const size_t PREFETCH_RING_SIZE = 4;
+
+// RequestBatch: preallocated arrays of decoded requests
+struct RequestBatch
+{
+    std::vector<uint64_t> times; // request times
+    std::vector<SimpleRequest> reqs;
+    size_t size; // number of valid requests
+    double sampleRate; // fraction of the trace's objects sampled
+    std::vector<SimpleRequest> dropped; // objects to evict before the batch (see TraceReader::droppedObjects)
+};
+
+/*
+  RequestPrefetcher: decodes a trace on a background thread
+
+  batches are decoded into a ring of RequestBatches while the caller
+  consumes the previous ones, so trace parsing and simulation overlap.
+  A consumer can hold several batches at once (acquire, release), they
+  are released in the order they were acquired.
+*/
+class RequestPrefetcher
+{
+protected:
+    std::unique_ptr<TraceReader> _trace;
+    std::vector<RequestBatch> _ring;
+    size_t _head; // next batch handed to the consumer
+    size_t _tail; // next batch filled by the reader thread
+    size_t _filled; // number of decoded batches in the ring
+    size_t _held; // batches from _head on held by the consumer
+    bool _done; // reader thread reached the end of the trace
+    bool _stop; // consumer shuts down the reader thread
+    std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::thread _thread;
+
+    void run();
+
+public:
+    RequestPrefetcher(std::unique_ptr<TraceReader> trace, size_t ringSize = PREFETCH_RING_SIZE);
+    ~RequestPrefetcher();
+
+    // release the previous batch and return the next one (nullptr at the end of the trace)
+    RequestBatch* next();
+
+    // hold the next batch as well (nullptr at the end of the trace),
+    // at most the ring size at once
+    RequestBatch* acquire();
+    // release the oldest batch held
+    void release();
+
+    size_t ringSize() const {
+        return _ring.size();
+    }
+
+    // false if the trace could not be read completely (valid at the end of the trace)
+    bool good() const {
+        return _trace->good();
+    }
+};
+
+#endif /* REQUEST_PREFETCHER_H */
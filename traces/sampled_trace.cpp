@@ -0,0 +1,119 @@
+#include <algorithm>
+#include "sampled_trace.h"
+
+SampledTraceReader::SampledTraceReader(std::unique_ptr<TraceReader> trace, double rate,
+                                       uint64_t maxObjects)
+    : TraceReader(),
+      _trace(std::move(trace)),
+      _threshold(rate >= 1.0 ? UINT64_MAX : uint64_t(std::ldexp(std::max(rate, 0.0), 64))),
+      _maxObjects(maxObjects),
+      _batchRate(rate),
+      _recs(nullptr),
+      _n(0),
+      _pos(0)
+{
+    _batch.reserve(TRACE_BATCH_SIZE);
+}
+
+void SampledTraceReader::shrink()
+{
+    while (_sampled.size() > _maxObjects) {
+        const HashedId largest = _largest.top();
+        _threshold = largest.first - 1;
+        // drop all objects above the new threshold (hash ties)
+        while (!_largest.empty() && _largest.top().first > _threshold) {
+            const auto it = _sampled.find(_largest.top().second);
+            _dropped.push_back(TraceRecord{0, it->first, it->second});
+            _sampled.erase(it);
+            _largest.pop();
+        }
+    }
+}
+
+size_t SampledTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    _batch.clear();
+    _dropped.clear();
+    while (_batch.size() < TRACE_BATCH_SIZE) {
+        if (_pos == _n) {
+            _n = _trace->nextBatch(_recs);
+            _pos = 0;
+            if (_n == 0) {
+                break;
+            }
+        }
+        const TraceRecord& rec = _recs[_pos];
+        const uint64_t h = mix64(rec.id);
+        if (h > _threshold) {
+            _pos++;
+            continue;
+        }
+        if (_maxObjects > 0) {
+            const auto it = _sampled.find(rec.id);
+            if (it != _sampled.end()) {
+                // caches hold the object with the size of its last request
+                it->second = rec.size;
+            } else {
+                if (_sampled.size() >= _maxObjects && !_batch.empty()) {
+                    // this object lowers the rate, it starts the next batch
+                    break;
+                }
+                _sampled.emplace(rec.id, rec.size);
+                _largest.push(HashedId(h, rec.id));
+                if (_sampled.size() > _maxObjects) {
+                    shrink();
+                    if (h > _threshold) {
+                        _pos++;
+                        continue;
+                    }
+                }
+            }
+        }
+        _batch.push_back(rec);
+        _pos++;
+    }
+    _batchRate = std::ldexp(double(_threshold), -64);
+    batch = _batch.data();
+    return _batch.size();
+}
+
+/*
+  SampleError
+*/
+SampleError::SampleError()
+{
+    for (size_t g = 0; g < SAMPLE_ERROR_GROUPS; g++) {
+        _reqs[g] = 0;
+        _hits[g] = 0;
+    }
+}
+
+double SampleError::stdError() const
+{
+    uint64_t reqs = 0, hits = 0;
+    for (size_t g = 0; g < SAMPLE_ERROR_GROUPS; g++) {
+        reqs += _reqs[g];
+        hits += _hits[g];
+    }
+    // hit ratios without each group
+    double ratios[SAMPLE_ERROR_GROUPS];
+    double mean = 0;
+    size_t groups = 0;
+    for (size_t g = 0; g < SAMPLE_ERROR_GROUPS; g++) {
+        if (_reqs[g] == 0 || _reqs[g] == reqs) {
+            continue;
+        }
+        ratios[groups] = double(hits - _hits[g]) / (reqs - _reqs[g]);
+        mean += ratios[groups];
+        groups++;
+    }
+    if (groups < 2) {
+        return NAN;
+    }
+    mean /= groups;
+    double var = 0;
+    for (size_t i = 0; i < groups; i++) {
+        var += (ratios[i] - mean) * (ratios[i] - mean);
+    }
+    return std::sqrt(var * (groups - 1) / groups);
+}
@@ -0,0 +1,97 @@
+#ifndef SAMPLED_TRACE_H
+#define SAMPLED_TRACE_H
+
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "traces/trace_reader.h"
+#include "hash.h"
+
+// hit ratio errors are estimated over this many groups of sampled objects
+const size_t SAMPLE_ERROR_GROUPS = 32;
+
+/*
+  SampledTraceReader: spatial (SHARDS-style) sampling of another TraceReader
+
+  keeps the requests of all objects whose id hash is below a threshold,
+  i.e., a fixed fraction (the sampling rate) of the objects with all their
+  requests. Caches simulated on the sample are scaled by the same rate.
+
+  With a limit on the number of sampled objects, the threshold is lowered
+  to the largest sampled hash whenever the limit is exceeded, which drops
+  that object and bounds memory. Every batch has a single rate: a batch
+  ends before a request that changes it. The dropped objects are never
+  requested again, but would still take up room in the scaled-down
+  caches, so they are reported (droppedObjects) for the caches to evict.
+*/
+class SampledTraceReader : public TraceReader
+{
+protected:
+    typedef std::pair<uint64_t, IdType> HashedId;
+
+    std::unique_ptr<TraceReader> _trace;
+    uint64_t _threshold; // requests with hash(id) < _threshold are sampled
+    uint64_t _maxObjects; // 0 for a fixed rate
+    std::priority_queue<HashedId> _largest; // sampled objects by hash (fixed number of objects)
+    std::unordered_map<IdType, uint64_t> _sampled; // sampled objects and their last sizes
+    std::vector<TraceRecord> _dropped; // by the shrinks before the batch last returned
+    double _batchRate; // rate of the batch last returned
+    const TraceRecord* _recs; // current batch of _trace
+    size_t _n;
+    size_t _pos;
+    std::vector<TraceRecord> _batch;
+
+    // lower the threshold until at most _maxObjects objects are sampled
+    void shrink();
+
+public:
+    // rate: sampled fraction of the objects in (0, 1];
+    // maxObjects: limit on the number of sampled objects, 0 for none
+    SampledTraceReader(std::unique_ptr<TraceReader> trace, double rate, uint64_t maxObjects = 0);
+    virtual ~SampledTraceReader() {}
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual void setDecodeTimes(bool decode) {
+        _trace->setDecodeTimes(decode);
+    }
+    virtual bool good() const {
+        return _trace->good();
+    }
+    virtual double sampleRate() const {
+        return _batchRate;
+    }
+    virtual size_t droppedObjects(const TraceRecord*& objects) const {
+        objects = _dropped.data();
+        return _dropped.size();
+    }
+};
+
+/*
+  SampleError: standard error of a hit ratio measured on a spatial sample
+
+  the sampled requests are split into SAMPLE_ERROR_GROUPS groups by
+  object (using hash bits independent of the sampling threshold), and a
+  delete-one-group jackknife over the groups estimates how much the hit
+  ratio depends on which objects were sampled
+*/
+class SampleError
+{
+protected:
+    uint64_t _reqs[SAMPLE_ERROR_GROUPS];
+    uint64_t _hits[SAMPLE_ERROR_GROUPS];
+
+public:
+    SampleError();
+
+    void add(IdType id, bool hit) {
+        const size_t g = mix64(id) % SAMPLE_ERROR_GROUPS;
+        _reqs[g]++;
+        _hits[g] += hit;
+    }
+    double stdError() const;
+};
+
+#endif /* SAMPLED_TRACE_H */
@@ -0,0 +1,60 @@
+#ifndef TEXT_PARSE_H
+#define TEXT_PARSE_H
+
+#include <cstdint>
+#include "traces/trace_reader.h"
+
+/*
+  helpers for parsing text traces in place, all functions work on [p, end)
+  and return the position after the parsed token (parseUInt: nullptr on failure)
+*/
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+inline const char* parseUInt(const char* p, const char* end, uint64_t& value)
+{
+    const char* start = p;
+    uint64_t v = 0;
+    // up to 19 decimal digits always fit into 64 bits
+    const char* fastEnd = (end - p > 19) ? p + 19 : end;
+    while (p < fastEnd && static_cast<unsigned char>(*p - '0') < 10) {
+        v = v * 10 + static_cast<unsigned char>(*p - '0');
+        p++;
+    }
+    if (p == start) {
+        return nullptr;
+    }
+    while (p < end && static_cast<unsigned char>(*p - '0') < 10) {
+        if (__builtin_mul_overflow(v, 10, &v)
+            || __builtin_add_overflow(v, static_cast<unsigned char>(*p - '0'), &v)) {
+            return nullptr;
+        }
+        p++;
+    }
+    value = v;
+    return p;
+}
+
+// parse one text trace line [begin, end) without its newline,
+// returns 1 for a request, 0 for a blank line, -1 for a malformed line
+inline int parseTraceLine(const char* begin, const char* end, TraceRecord& rec)
+{
+    const char* p = skipBlanks(begin, end);
+    if (p == end) {
+        return 0;
+    }
+    if ((p = parseUInt(p, end, rec.t)) == nullptr
+        || (p = parseUInt(skipBlanks(p, end), end, rec.id)) == nullptr
+        || (p = parseUInt(skipBlanks(p, end), end, rec.size)) == nullptr) {
+        return -1;
+    }
+    return skipBlanks(p, end) == end ? 1 : -1;
+}
+
+#endif /* TEXT_PARSE_H */
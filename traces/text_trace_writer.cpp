@@ -0,0 +1,42 @@
+#include <iostream>
+#include "text_trace_writer.h"
+
+TextTraceWriter::TextTraceWriter()
+    : _outfile(NULL),
+      _buffer(1 << 20),
+      _pos(0)
+{
+}
+
+TextTraceWriter::~TextTraceWriter()
+{
+    if (_outfile != NULL) {
+        close();
+    }
+}
+
+bool TextTraceWriter::open(const std::string& path)
+{
+    _outfile = fopen(path.c_str(), "wb");
+    if (_outfile == NULL) {
+        std::cerr << "cannot open output " << path << std::endl;
+        return false;
+    }
+    _pos = 0;
+    return true;
+}
+
+bool TextTraceWriter::flush()
+{
+    const bool ok = fwrite(_buffer.data(), 1, _pos, _outfile) == _pos;
+    _pos = 0;
+    return ok;
+}
+
+bool TextTraceWriter::close()
+{
+    bool ok = flush();
+    ok = (fclose(_outfile) == 0) && ok;
+    _outfile = NULL;
+    return ok;
+}
@@ -0,0 +1,54 @@
+#ifndef TEXT_TRACE_WRITER_H
+#define TEXT_TRACE_WRITER_H
+
+#include <cstdio>
+#include <vector>
+#include "traces/trace_reader.h"
+
+/*
+  TextTraceWriter: buffered writer for three column text traces
+*/
+class TextTraceWriter
+{
+protected:
+    FILE* _outfile;
+    std::vector<char> _buffer;
+    size_t _pos; // end of buffered data
+
+    bool flush();
+
+    // append the decimal digits of v
+    void putUInt(uint64_t v) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + v % 10;
+            v /= 10;
+        } while (v > 0);
+        while (n > 0) {
+            _buffer[_pos++] = digits[--n];
+        }
+    }
+
+public:
+    TextTraceWriter();
+    ~TextTraceWriter();
+
+    bool open(const std::string& path);
+    bool write(const TraceRecord& rec) {
+        // three numbers of up to 20 digits, two spaces and a newline
+        if (_pos + 64 > _buffer.size() && !flush()) {
+            return false;
+        }
+        putUInt(rec.t);
+        _buffer[_pos++] = ' ';
+        putUInt(rec.id);
+        _buffer[_pos++] = ' ';
+        putUInt(rec.size);
+        _buffer[_pos++] = '\n';
+        return true;
+    }
+    bool close();
+};
+
+#endif /* TEXT_TRACE_WRITER_H */
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace_index.h"
+#include "text_parse.h"
+
+std::string traceIndexPath(const std::string& tracePath)
+{
+    return tracePath + ".idx";
+}
+
+bool buildTraceIndex(const std::string& tracePath)
+{
+    TraceIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!traceStamp(tracePath, header.traceSize, header.traceMtime)) {
+        std::cerr << "cannot stat trace " << tracePath << std::endl;
+        return false;
+    }
+    const int fd = open(tracePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "cannot open trace " << tracePath << std::endl;
+        return false;
+    }
+    const char* map = nullptr;
+    if (header.traceSize > 0) {
+        void* m = mmap(NULL, header.traceSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            std::cerr << "cannot mmap trace " << tracePath << std::endl;
+            close(fd);
+            return false;
+        }
+        madvise(m, header.traceSize, MADV_SEQUENTIAL);
+        map = static_cast<const char*>(m);
+    }
+    close(fd);
+
+    // entries for requests 0, interval, 2*interval, ...
+    std::vector<TraceIndexEntry> entries;
+    const char* p = map;
+    const char* end = map + header.traceSize;
+    uint64_t line = 0;
+    TraceRecord rec;
+    bool ok = true;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (eol == nullptr) {
+            eol = end;
+        }
+        const int parsed = parseTraceLine(p, eol, rec);
+        if (parsed < 0) {
+            std::cerr << tracePath << ":" << line + 1 << ": malformed trace line \""
+                      << std::string(p, eol) << "\"" << std::endl;
+            ok = false;
+            break;
+        }
+        if (parsed > 0) {
+            if (header.count % TRACE_INDEX_INTERVAL == 0) {
+                TraceIndexEntry entry = {header.count, line, rec.t, uint64_t(p - map)};
+                entries.push_back(entry);
+            }
+            header.count++;
+        }
+        line++;
+        p = eol + 1;
+    }
+    if (map != nullptr) {
+        munmap(const_cast<char*>(map), header.traceSize);
+    }
+    if (!ok) {
+        return false;
+    }
+    if (entries.empty()) {
+        TraceIndexEntry entry = {0, 0, 0, 0};
+        entries.push_back(entry);
+    }
+
+    // write to a temporary file, so an interrupted pass leaves no stale index
+    const std::string path = traceIndexPath(tracePath);
+    const std::string tmpPath = path + ".tmp";
+    FILE* outfile = fopen(tmpPath.c_str(), "wb");
+    if (outfile == NULL) {
+        std::cerr << "cannot open output " << tmpPath << std::endl;
+        return false;
+    }
+    memcpy(header.magic, TRACE_INDEX_MAGIC, sizeof(TRACE_INDEX_MAGIC));
+    header.version = TRACE_INDEX_VERSION;
+    header.interval = TRACE_INDEX_INTERVAL;
+    header.entries = entries.size();
+    ok = fwrite(&header, sizeof(header), 1, outfile) == 1
+        && fwrite(entries.data(), sizeof(TraceIndexEntry), entries.size(), outfile) == entries.size();
+    ok = (fclose(outfile) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "cannot write trace index " << path << std::endl;
+        remove(tmpPath.c_str());
+        return false;
+    }
+    std::cerr << "trace index: " << header.count << " requests, "
+              << header.entries << " entries" << std::endl;
+    return true;
+}
+
+/*
+  TraceIndex
+*/
+TraceIndex::TraceIndex()
+    : _count(0)
+{
+}
+
+bool TraceIndex::load(const std::string& tracePath)
+{
+    uint64_t traceSize, traceMtime;
+    if (!traceStamp(tracePath, traceSize, traceMtime)) {
+        return false;
+    }
+    FILE* infile = fopen(traceIndexPath(tracePath).c_str(), "rb");
+    if (infile == NULL) {
+        return false;
+    }
+    TraceIndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, infile) == 1
+        && memcmp(header.magic, TRACE_INDEX_MAGIC, sizeof(TRACE_INDEX_MAGIC)) == 0
+        && header.version == TRACE_INDEX_VERSION
+        && header.traceSize == traceSize
+        && header.traceMtime == traceMtime
+        && header.entries > 0
+        && header.entries <= header.count / header.interval + 1;
+    if (ok) {
+        _entries.resize(header.entries);
+        ok = fread(_entries.data(), sizeof(TraceIndexEntry), _entries.size(), infile) == _entries.size();
+    }
+    fclose(infile);
+    if (!ok) {
+        // stale or foreign index
+        _entries.clear();
+        return false;
+    }
+    _count = header.count;
+    return true;
+}
+
+std::unique_ptr<TraceIndex> TraceIndex::create_unique(const std::string& tracePath)
+{
+    // offsets into compressed traces cannot be seeked to
+    if (isCompressed(tracePath)) {
+        return nullptr;
+    }
+    std::unique_ptr<TraceIndex> index(new TraceIndex());
+    if (index->load(tracePath)) {
+        return index;
+    }
+    std::cerr << "building trace index " << traceIndexPath(tracePath) << std::endl;
+    if (buildTraceIndex(tracePath) && index->load(tracePath)) {
+        return index;
+    }
+    std::cerr << "cannot read trace index " << traceIndexPath(tracePath) << std::endl;
+    return nullptr;
+}
+
+const TraceIndexEntry& TraceIndex::findRequest(uint64_t request) const
+{
+    auto it = std::upper_bound(_entries.begin(), _entries.end(), request,
+                               [](uint64_t r, const TraceIndexEntry& e) { return r < e.request; });
+    return *(it == _entries.begin() ? it : it - 1);
+}
+
+const TraceIndexEntry& TraceIndex::findTime(uint64_t t) const
+{
+    // first entry at or after t, the requests before it may still be at or after t
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), t,
+                               [](const TraceIndexEntry& e, uint64_t v) { return e.time < v; });
+    return *(it == _entries.begin() ? it : it - 1);
+}
@@ -0,0 +1,75 @@
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "traces/trace_reader.h"
+
+/*
+  Text trace index
+
+  a sparse sidecar file next to an uncompressed text trace (trace path +
+  ".idx") with one entry every TRACE_INDEX_INTERVAL requests: the request
+  number, its line number, time, and the byte offset of its line. Like
+  the dense id mapping, the trace's size and modification time detect
+  stale indexes.
+*/
+const char TRACE_INDEX_MAGIC[8] = {'W', 'C', 'S', 'T', 'R', 'I', 'D', 'X'};
+const uint32_t TRACE_INDEX_VERSION = 1;
+const uint32_t TRACE_INDEX_INTERVAL = 1 << 16;
+
+struct TraceIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t interval; // requests between entries
+    uint64_t traceSize; // size of the trace file
+    uint64_t traceMtime; // modification time of the trace file (ns)
+    uint64_t count; // number of requests
+    uint64_t entries; // number of entries
+};
+
+struct TraceIndexEntry
+{
+    uint64_t request; // number of the request (counted from 0)
+    uint64_t line; // lines before the request's line
+    uint64_t time; // time of the request
+    uint64_t offset; // file offset of the request's line
+};
+
+// path of the index file of a trace
+std::string traceIndexPath(const std::string& tracePath);
+
+// build the index file of an uncompressed text trace in one pass, false on errors
+bool buildTraceIndex(const std::string& tracePath);
+
+/*
+  TraceIndex: index entries of a text trace
+*/
+class TraceIndex
+{
+protected:
+    std::vector<TraceIndexEntry> _entries; // at least one, for request 0
+    uint64_t _count;
+
+public:
+    TraceIndex();
+
+    // read the index file, false if it is missing or does not match the trace
+    bool load(const std::string& tracePath);
+
+    // load the index of a trace, the index file is built first if it is missing or stale
+    static std::unique_ptr<TraceIndex> create_unique(const std::string& tracePath);
+
+    // number of requests in the trace
+    uint64_t count() const {
+        return _count;
+    }
+    // last entry at or before request
+    const TraceIndexEntry& findRequest(uint64_t request) const;
+    // last entry before the first request at or after time t
+    const TraceIndexEntry& findTime(uint64_t t) const;
+};
+
+#endif /* TRACE_INDEX_H */
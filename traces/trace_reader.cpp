@@ -0,0 +1,178 @@
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <sys/stat.h>
+#include "trace_reader.h"
+#include "binary_trace.h"
+#include "columnar_trace.h"
+#include "parallel_text_trace.h"
+#include "text_parse.h"
+#include "trace_index.h"
+
+unsigned int TraceReader::defaultThreads()
+{
+    return std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+}
+
+bool traceStamp(const std::string& path, uint64_t& size, uint64_t& mtime)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = st.st_size;
+    mtime = uint64_t(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec;
+    return true;
+}
+
+std::unique_ptr<TraceReader> TraceReader::create_unique(const std::string& path, unsigned int threads,
+                                                        const LineParser* parser)
+{
+    if (parser == nullptr && isColumnarTrace(path)) {
+        std::unique_ptr<ColumnarTraceReader> reader(new ColumnarTraceReader(path, threads));
+        if (!reader->isOpen()) {
+            return nullptr;
+        }
+        return std::move(reader);
+    }
+    if (parser == nullptr && isBinaryTrace(path)) {
+        std::unique_ptr<BinaryTraceReader> reader(new BinaryTraceReader(path));
+        if (!reader->isOpen()) {
+            return nullptr;
+        }
+        return std::move(reader);
+    }
+    // large uncompressed text traces are split into chunks parsed in parallel
+    struct stat st;
+    if (threads > 1 && !isCompressed(path)
+        && stat(path.c_str(), &st) == 0 && size_t(st.st_size) >= PARALLEL_MIN_TRACE_SIZE) {
+        std::unique_ptr<ParallelTextTraceReader> reader(new ParallelTextTraceReader(path, threads, parser));
+        if (!reader->isOpen()) {
+            return nullptr;
+        }
+        return std::move(reader);
+    }
+    std::unique_ptr<TextTraceReader> reader(new TextTraceReader(path, parser));
+    if (!reader->isOpen()) {
+        return nullptr;
+    }
+    return std::move(reader);
+}
+
+/*
+  TextTraceReader
+*/
+// size of the blocks read from the trace file
+const size_t TEXT_BLOCK_SIZE = 1 << 22;
+
+TextTraceReader::TextTraceReader(const std::string& path, const LineParser* parser)
+    : TraceReader(),
+      _path(path),
+      _parser(parser),
+      _input(InputStream::create_unique(path)),
+      _buffer(TEXT_BLOCK_SIZE),
+      _pos(0),
+      _end(0),
+      _eof(false),
+      _good(true),
+      _line(0),
+      _batch(TRACE_BATCH_SIZE)
+{
+}
+
+TextTraceReader::~TextTraceReader()
+{
+}
+
+void TextTraceReader::fill()
+{
+    // keep the unparsed (partial) line
+    const size_t rest = _end - _pos;
+    if (rest > 0 && _pos > 0) {
+        memmove(_buffer.data(), _buffer.data() + _pos, rest);
+    }
+    _pos = 0;
+    _end = rest;
+    if (_end == _buffer.size()) {
+        // a single line longer than the buffer
+        _buffer.resize(2 * _buffer.size());
+    }
+    const ssize_t r = _input->read(_buffer.data() + _end, _buffer.size() - _end);
+    if (r < 0) {
+        _good = false;
+        _eof = true;
+    } else if (r == 0) {
+        _eof = true;
+    } else {
+        _end += r;
+    }
+}
+
+size_t TextTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    size_t n = 0;
+    batch = _batch.data();
+    while (n < _batch.size() && _good) {
+        const char* begin = _buffer.data() + _pos;
+        const char* end = _buffer.data() + _end;
+        // memchr is vectorized in common libc implementations
+        const char* eol = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        if (eol == nullptr) {
+            if (!_eof) {
+                fill();
+                continue;
+            }
+            if (begin == end) {
+                break;
+            }
+            // last line without newline
+            eol = end;
+        }
+        _line++;
+        int parsed;
+        if (_parser == nullptr) {
+            parsed = parseTraceLine(begin, eol, _batch[n]);
+        } else {
+            parsed = _line > _parser->headerLines() ? _parser->parse(begin, eol, _batch[n]) : 0;
+        }
+        if (parsed < 0) {
+            std::cerr << _path << ":" << _line << ": malformed trace line \""
+                      << std::string(begin, eol) << "\"" << std::endl;
+            _good = false;
+            break;
+        }
+        n += parsed;
+        _pos = (eol == end) ? _end : (eol - _buffer.data()) + 1;
+    }
+    return n;
+}
+
+uint64_t TextTraceReader::seekRequest(uint64_t request)
+{
+    std::unique_ptr<TraceIndex> index;
+    if (_parser != nullptr || !(index = TraceIndex::create_unique(_path))) {
+        return 0;
+    }
+    return seek(index->findRequest(request));
+}
+
+uint64_t TextTraceReader::seekTime(uint64_t t)
+{
+    std::unique_ptr<TraceIndex> index;
+    if (_parser != nullptr || !(index = TraceIndex::create_unique(_path))) {
+        return 0;
+    }
+    return seek(index->findTime(t));
+}
+
+uint64_t TextTraceReader::seek(const TraceIndexEntry& entry)
+{
+    if (!_input->seek(entry.offset)) {
+        return 0;
+    }
+    _pos = 0;
+    _end = 0;
+    _eof = false;
+    _line = entry.line;
+    return entry.request;
+}
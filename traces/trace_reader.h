@@ -0,0 +1,143 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "request.h"
+#include "traces/input_stream.h"
+
+struct TraceIndexEntry;
+
+// number of requests handed out per batch
+const size_t TRACE_BATCH_SIZE = 4096;
+
+// TraceRecord is one request of a trace: (time, id, size)
+// the layout is also the on-disk record of the binary trace format
+struct TraceRecord
+{
+    uint64_t t; // request time
+    IdType id; // request object id
+    uint64_t size; // request size in bytes
+};
+
+/*
+  LineParser: parses the lines of text traces in other formats (see traceparser/)
+*/
+class LineParser
+{
+public:
+    LineParser() {}
+    virtual ~LineParser() {}
+
+    // parse one line [begin, end) without its newline, returns 1 for a
+    // request, 0 for a line without a request, -1 for a malformed line
+    virtual int parse(const char* begin, const char* end, TraceRecord& rec) const = 0;
+
+    // number of header lines skipped at the start of the file
+    virtual uint64_t headerLines() const {
+        return 0;
+    }
+};
+
+/*
+  TraceReader: reads a request trace in batches of TraceRecords
+*/
+class TraceReader
+{
+public:
+    TraceReader() {}
+    virtual ~TraceReader() {}
+
+    // point batch to the next requests and return how many there are
+    // (0 at the end of the trace), records stay valid until the next call
+    virtual size_t nextBatch(const TraceRecord*& batch) = 0;
+
+    // false if the trace could not be read completely
+    virtual bool good() const {
+        return true;
+    }
+
+    // formats with a separate time column skip decoding it if not needed
+    virtual void setDecodeTimes(bool decode) {}
+
+    // move to request number request (counted from 0) before the first
+    // nextBatch call. Formats with an index jump to this request or an
+    // earlier one and return the number of the request read next, other
+    // formats stay at the start and return 0
+    virtual uint64_t seekRequest(uint64_t request) {
+        return 0;
+    }
+    // same for the first request at or after time t (traces are in time order)
+    virtual uint64_t seekTime(uint64_t t) {
+        return 0;
+    }
+
+    // fraction of the trace's objects in the batch last returned (see SampledTraceReader)
+    virtual double sampleRate() const {
+        return 1.0;
+    }
+    // point objects to the objects a sample dropped right before the batch
+    // last returned (id and last size) and return how many there are
+    virtual size_t droppedObjects(const TraceRecord*& objects) const {
+        return 0;
+    }
+
+    // open a trace file, the format is detected from the file header,
+    // large traces are decoded with up to threads threads.
+    // With a parser, the file is read as a text trace in the parser's format
+    static std::unique_ptr<TraceReader> create_unique(const std::string& path,
+                                                      unsigned int threads = 1,
+                                                      const LineParser* parser = nullptr);
+
+    // default number of decoding threads
+    static unsigned int defaultThreads();
+};
+
+// identify the version of a trace file for its sidecar files (size and mtime in ns)
+bool traceStamp(const std::string& path, uint64_t& size, uint64_t& mtime);
+
+/*
+  TextTraceReader: space-separated three column text traces (see README)
+
+  reads the file in large blocks and parses lines in place,
+  gzip and zstd compressed traces are decompressed on the fly
+*/
+class TextTraceReader : public TraceReader
+{
+protected:
+    std::string _path;
+    const LineParser* _parser; // nullptr for three column traces
+    std::unique_ptr<InputStream> _input;
+    std::vector<char> _buffer;
+    size_t _pos; // first unparsed byte in _buffer
+    size_t _end; // end of valid data in _buffer
+    bool _eof;
+    bool _good;
+    uint64_t _line; // number of lines parsed so far
+    std::vector<TraceRecord> _batch;
+
+    // move unparsed data to the front of the buffer and read the next block
+    void fill();
+    // continue reading at an index entry
+    uint64_t seek(const TraceIndexEntry& entry);
+
+public:
+    TextTraceReader(const std::string& path, const LineParser* parser = nullptr);
+    virtual ~TextTraceReader();
+
+    bool isOpen() const {
+        return _input != nullptr;
+    }
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual bool good() const {
+        return _good;
+    }
+    virtual uint64_t seekRequest(uint64_t request);
+    virtual uint64_t seekTime(uint64_t t);
+};
+
+#endif /* TRACE_READER_H */
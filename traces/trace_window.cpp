@@ -0,0 +1,57 @@
+#include "trace_window.h"
+
+WindowTraceReader::WindowTraceReader(std::unique_ptr<TraceReader> trace, const TraceWindow& window)
+    : TraceReader(),
+      _trace(std::move(trace)),
+      _window(window),
+      _started(false),
+      _inWindow(false),
+      _done(false),
+      _request(0)
+{
+}
+
+void WindowTraceReader::seek()
+{
+    if (_window.startTime > 0) {
+        _request = _trace->seekTime(_window.startTime);
+        // seeking by time may stop before startRequest, the rest is skipped
+    } else if (_window.startRequest > 0) {
+        _request = _trace->seekRequest(_window.startRequest);
+    }
+    _started = true;
+}
+
+size_t WindowTraceReader::nextBatch(const TraceRecord*& batch)
+{
+    if (!_started) {
+        seek();
+    }
+    while (!_done) {
+        const TraceRecord* recs;
+        const size_t n = _trace->nextBatch(recs);
+        if (n == 0) {
+            _done = true;
+            break;
+        }
+        size_t first = 0;
+        if (!_inWindow) {
+            while (first < n && (_request + first < _window.startRequest
+                                 || recs[first].t < _window.startTime)) {
+                first++;
+            }
+            _inWindow = first < n;
+        }
+        size_t last = first;
+        while (last < n && _request + last < _window.endRequest && recs[last].t < _window.endTime) {
+            last++;
+        }
+        _done = last < n;
+        _request += n;
+        if (last > first) {
+            batch = recs + first;
+            return last - first;
+        }
+    }
+    return 0;
+}
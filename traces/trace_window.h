@@ -0,0 +1,71 @@
+#ifndef TRACE_WINDOW_H
+#define TRACE_WINDOW_H
+
+#include <cstdint>
+#include <memory>
+#include "traces/trace_reader.h"
+
+/*
+  TraceWindow: part of a trace to replay
+
+  requests [startRequest, endRequest) (counted from 0), starting at the
+  first request at or after startTime and ending before the first
+  request at or after endTime
+*/
+struct TraceWindow
+{
+    uint64_t startRequest;
+    uint64_t endRequest;
+    uint64_t startTime;
+    uint64_t endTime;
+
+    TraceWindow()
+        : startRequest(0),
+          endRequest(UINT64_MAX),
+          startTime(0),
+          endTime(UINT64_MAX)
+    {
+    }
+
+    // false for the whole trace
+    bool active() const {
+        return startRequest > 0 || endRequest < UINT64_MAX || usesTimes();
+    }
+    bool usesTimes() const {
+        return startTime > 0 || endTime < UINT64_MAX;
+    }
+};
+
+/*
+  WindowTraceReader: replays a window of another TraceReader
+
+  seeks the trace close to the start of the window (see seekRequest and
+  seekTime) and skips the remaining requests before it
+*/
+class WindowTraceReader : public TraceReader
+{
+protected:
+    std::unique_ptr<TraceReader> _trace;
+    TraceWindow _window;
+    bool _started; // the trace was seeked
+    bool _inWindow; // the first request of the window was reached
+    bool _done; // the end of the window was reached
+    uint64_t _request; // number of the next request read from _trace
+
+    // skip to the start of the window
+    void seek();
+
+public:
+    WindowTraceReader(std::unique_ptr<TraceReader> trace, const TraceWindow& window);
+    virtual ~WindowTraceReader() {}
+
+    virtual size_t nextBatch(const TraceRecord*& batch);
+    virtual void setDecodeTimes(bool decode) {
+        _trace->setDecodeTimes(decode || _window.usesTimes());
+    }
+    virtual bool good() const {
+        return _trace->good();
+    }
+};
+
+#endif /* TRACE_WINDOW_H */
@@ -1,81 +1,338 @@
-#include <fstream>
 #include <string>
+#include <exception>
 #include <regex>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "traces/trace_reader.h"
+#include "traces/request_prefetcher.h"
+#include "traces/dense_ids.h"
+#include "traces/trace_window.h"
+#include "traces/sampled_trace.h"
 #include "caches/lru_variants.h"
 #include "caches/gd_variants.h"
+#include "cache_sweep.h"
+#include "experiment_runner.h"
+#include "replay_stats.h"
+#include "lru_mrc.h"
 #include "request.h"
 
 using namespace std;
 
+// cache size simulated on a sample of the trace's objects
+static uint64_t sampledSize(uint64_t cacheSize, double sampleRate)
+{
+  if(sampleRate >= 1.0)
+    return cacheSize;
+  return std::max<uint64_t>(1, llround(cacheSize * sampleRate));
+}
+
+// create a cache and configure its size and parameters
+static unique_ptr<Cache> createCache(const string& cacheType, uint64_t cacheSize,
+                                     const vector<string>& params)
+{
+  unique_ptr<Cache> webcache = Cache::create_unique(cacheType);
+  if(webcache == nullptr)
+    return nullptr;
+
+  // configure cache size
+  webcache->setSize(cacheSize);
+
+  // parse cache parameters, name=value or a bare value (W_TinyLFU's window)
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  for(size_t i=0; i<params.size(); i++) {
+    bool known;
+    if(regex_match (params[i].c_str(),opmatch,opexp))
+      known = webcache->setPar(opmatch[1], opmatch[2]);
+    else
+      known = webcache->setPar("", params[i]);
+    if(!known) {
+      cerr << "unrecognized parameter for " << cacheType << ": " << params[i] << endl;
+      return nullptr;
+    }
+  }
+  return webcache;
+}
+
+// cacheParams as printed in results lines
+static string paramSummary(const vector<string>& params)
+{
+  string summary;
+  for(size_t i=0; i<params.size(); i++)
+    summary += (i > 0 ? " " : "") + params[i];
+  return summary;
+}
+
+// read sweep configurations, one "cacheType cacheSizeBytes [cacheParams]" per line
+static bool readSweepConfig(const char* path, double sampleRate, CacheSweep& sweep)
+{
+  ifstream infile(path);
+  if(!infile) {
+    cerr << "cannot open sweep configuration " << path << endl;
+    return false;
+  }
+  string line;
+  int lineNo = 0;
+  while(getline(infile, line)) {
+    lineNo++;
+    istringstream ss(line);
+    vector<string> words;
+    string word;
+    while(ss >> word)
+      words.push_back(word);
+    if(words.empty() || words[0][0] == '#')
+      continue;
+    if(words.size() < 2) {
+      cerr << path << ":" << lineNo << ": expected cacheType cacheSizeBytes [cacheParams]" << endl;
+      return false;
+    }
+    const vector<string> params(words.begin() + 2, words.end());
+    const uint64_t cache_size = std::stoull(words[1]);
+    unique_ptr<Cache> webcache = createCache(words[0], sampledSize(cache_size, sampleRate), params);
+    if(webcache == nullptr)
+      return false;
+    // same results line as a single run
+    const string name = words[0] + " " + words[1] + " " + paramSummary(params);
+    sweep.add(name, move(webcache), cache_size);
+  }
+  if(sweep.size() == 0) {
+    cerr << "no configurations in " << path << endl;
+    return false;
+  }
+  return true;
+}
+
 int main (int argc, char* argv[])
 {
 
+  // simulator options
+  unsigned int threads = TraceReader::defaultThreads();
+  bool denseIds = false;
+  TraceWindow window;
+  const char* sweepConfig = nullptr;
+  const char* experiment = nullptr;
+  const char* resultsPath = "results.csv";
+  bool lruCurve = false;
+  double sampleRate = 1.0;
+  uint64_t sampleObjects = 0;
+  StatsConfig stats;
+  unsigned int sweepThreads = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+  int opt;
+  while ((opt = getopt(argc, argv, "+j:ds:e:S:E:c:w:mr:R:W:i:I:Hx:o:")) != -1) {
+    switch (opt) {
+    case 'j':
+      threads = std::stoul(optarg);
+      break;
+    case 'd':
+      denseIds = true;
+      break;
+    case 's':
+      window.startRequest = std::stoull(optarg);
+      break;
+    case 'e':
+      window.endRequest = std::stoull(optarg);
+      break;
+    case 'S':
+      window.startTime = std::stoull(optarg);
+      break;
+    case 'E':
+      window.endTime = std::stoull(optarg);
+      break;
+    case 'c':
+      sweepConfig = optarg;
+      break;
+    case 'w':
+      sweepThreads = std::stoul(optarg);
+      break;
+    case 'm':
+      lruCurve = true;
+      break;
+    case 'r':
+      sampleRate = std::stod(optarg);
+      break;
+    case 'R':
+      sampleObjects = std::stoull(optarg);
+      break;
+    case 'W':
+      if(string(optarg) == "fill")
+        stats.warmupFill = true;
+      else
+        stats.warmupRequests = std::stoull(optarg);
+      break;
+    case 'i':
+      stats.intervalRequests = std::stoull(optarg);
+      break;
+    case 'I':
+      stats.intervalTime = std::stoull(optarg);
+      break;
+    case 'H':
+      stats.sizeClasses = true;
+      break;
+    case 'x':
+      experiment = optarg;
+      break;
+    case 'o':
+      resultsPath = optarg;
+      break;
+    default:
+      return 1;
+    }
+  }
+  // skip options, argv[1] is the trace file
+  argc -= optind - 1;
+  argv += optind - 1;
+
   // output help if insufficient params
-  if(argc < 4) {
-    cerr << "webcachesim traceFile cacheType cacheSizeBytes [cacheParams]" << endl;
+  if(argc < (experiment != nullptr ? 1 : sweepConfig != nullptr || lruCurve ? 2 : 4)) {
+    cerr << "webcachesim [-j traceThreads] [-d] [-s startRequest] [-e endRequest]"
+         << " [-S startTime] [-E endTime] [-r sampleRate] [-R sampleObjects]"
+         << " [-W warmupRequests|fill] [-i intervalRequests] [-I intervalTime] [-H]"
+         << " traceFile cacheType cacheSizeBytes [cacheParams]" << endl;
+    cerr << "webcachesim [options] -c sweepConfig [-w sweepThreads] traceFile" << endl;
+    cerr << "webcachesim [options] -m traceFile" << endl;
+    cerr << "webcachesim [-W warmupRequests|fill] -x experiment [-o results.csv] [-w threads]" << endl;
     return 1;
   }
 
+  // run the jobs of an experiment matrix, each on one thread
+  if(experiment != nullptr) {
+    vector<ExperimentJob> jobs;
+    if(!readExperiment(experiment, jobs))
+      return 1;
+    ExperimentRunner runner(sweepThreads, stats, [](const ExperimentJob& job) {
+        return createCache(job.cacheType, job.cacheSize, job.params);
+      }, resultsPath);
+    return runner.run(jobs) ? 0 : 1;
+  }
+
   // trace properties
   const char* path = argv[1];
-
-  // create cache
-  const string cacheType = argv[2];
-  unique_ptr<Cache> webcache = Cache::create_unique(cacheType);
-  if(webcache == nullptr)
+  const bool sampled = sampleRate < 1.0 || sampleObjects > 0;
+  stats.sampled = sampled;
+  if(sampleRate <= 0 || sampleRate > 1) {
+    cerr << "sampling rate must be in (0, 1]" << endl;
     return 1;
+  }
+  if(lruCurve && sampleObjects > 0) {
+    cerr << "LRU curves need a fixed sampling rate" << endl;
+    return 1;
+  }
 
-  // configure cache size
-  const uint64_t cache_size  = std::stoull(argv[3]);
-  webcache->setSize(cache_size);
-
-  // parse cache parameters
-  regex opexp ("(.*)=(.*)");
-  cmatch opmatch;
-  string paramSummary;
-  for(int i=4; i<argc; i++) {
-    regex_match (argv[i],opmatch,opexp);
-    //std::cout <<" regex match size = " << opmatch.size() << endl;
-    //std::cout << "REGEX : 0 " << opmatch[0] << " 1 " << opmatch[1] << " 2 " << opmatch[2] << " 3 " <<  opmatch[3] << 'n';
-    //  if(opmatch.size()!=3) {
-    //   cerr << "each cacheParam needs to be in form name=value" << endl;
-    //   return 1;
-    // }
-    //webcache->setPar(opmatch[1], opmatch[2]);
-    webcache->setPar(argv[4],argv[4]);
-    //paramSummary += opmatch[2];
+  // create caches, a sweep runs every configuration of the file in one pass
+  CacheSweep sweep(sweepThreads, stats, sampleRate);
+  string cacheType, params;
+  uint64_t cache_size = 0;
+  unique_ptr<Cache> webcache;
+  if(sweepConfig != nullptr) {
+    if(!readSweepConfig(sweepConfig, sampleRate, sweep))
+      return 1;
+  } else if(lruCurve) {
+    // the whole LRU curve is computed from stack distances, no cache needed
+  } else {
+    cacheType = argv[2];
+    cache_size = std::stoull(argv[3]);
+    const vector<string> cacheParams(argv + 4, argv + argc);
+    webcache = createCache(cacheType, sampledSize(cache_size, sampleRate), cacheParams);
+    if(webcache == nullptr)
+      return 1;
+    params = paramSummary(cacheParams);
   }
 
-  ifstream infile;
-  long long reqs = 0, hits = 0;
-  long long t, id, size;
+  unique_ptr<TraceReader> trace;
+  if(denseIds) {
+    // remap ids to [0, objects) using the trace's sidecar mapping
+    unique_ptr<DenseIdReader> dense = DenseIdReader::create_unique(path, threads);
+    if(dense == nullptr)
+      return 1;
+    if(webcache != nullptr)
+      webcache->setTraceInfo(dense->objects(), true);
+    sweep.setTraceInfo(dense->objects(), true);
+    trace = move(dense);
+  } else {
+    trace = TraceReader::create_unique(path, threads);
+  }
+  if(trace == nullptr)
+    return 1;
+  // compact policies (LRU32) need dense ids that fit their id width
+  if(webcache != nullptr && !webcache->checkTraceIds(cacheType))
+    return 1;
+  if(!sweep.checkTraceIds())
+    return 1;
+  // replay only part of the trace, indexed traces seek to its start
+  if(window.active())
+    trace.reset(new WindowTraceReader(move(trace), window));
+  // simulate a spatial sample of the objects on caches scaled by the sampling rate
+  if(sampled)
+    trace.reset(new SampledTraceReader(move(trace), sampleRate, sampleObjects));
+  // no policy uses request times, only intervals of trace time do
+  trace->setDecodeTimes(stats.intervalTime > 0);
 
   cerr << "running..." << endl;
 
-  infile.open(path);
-  SimpleRequest* req = new SimpleRequest(0, 0);
-  while (infile >> t >> id >> size)
-    {
-      //cout << "looking for  object  " << id << endl;
-        //std::cout << "Line is : " << t  <<  " " << id <<  " " << size << std::endl;  
-        reqs++;
-        //cout << "reading line" << endl;
-        req->reinit(id,size);
-        if(webcache->lookup(req)) {
-       // cout << "obj hit "<< id << endl;
-            hits++;
-        } else {
-        //cout << "obj miss "<< id << endl;
-            webcache->admit(req);
+  // decode the trace on a background thread while simulating
+  // a sweep holds up to SWEEP_WINDOW batches itself
+  const size_t ringSize = PREFETCH_RING_SIZE + (sweepConfig != nullptr ? SWEEP_WINDOW : 0);
+  RequestPrefetcher prefetcher(move(trace), ringSize);
+  RequestBatch* batch;
+  if(sweepConfig != nullptr) {
+    if(!sweep.run(prefetcher))
+      return 1;
+    sweep.print(cout);
+    return sweep.complete() ? 0 : 1;
+  }
+  if(lruCurve) {
+    LRUMissRatioCurve curve;
+    while ((batch = prefetcher.next()) != nullptr)
+      for (size_t i = 0; i < batch->size; i++)
+        curve.request(&batch->reqs[i]);
+    if(!prefetcher.good())
+      return 1;
+    curve.print(cout, sampleRate);
+    return 0;
+  }
+  double rate = sampleRate;
+  ReplayStats replay(stats);
+  try {
+    while ((batch = prefetcher.next()) != nullptr)
+      {
+        // a sample limited to a number of objects lowers its rate over time,
+        // the caches drop the objects it no longer samples and shrink
+        if(batch->sampleRate != rate) {
+          rate = batch->sampleRate;
+          for (auto& req : batch->dropped)
+            webcache->evict(&req);
+          webcache->setSize(sampledSize(cache_size, rate));
         }
-    }
+        // one virtual call per batch, see Cache::process_batch
+        replay.replay(webcache.get(), batch);
+      }
+  } catch(const std::exception& e) {
+    // e.g. a request a compact cache object cannot hold
+    cerr << cacheType << ": " << e.what() << endl;
+    return 1;
+  }
 
-  delete req;
+  if(!prefetcher.good())
+    return 1;
 
-  infile.close();
-  cout << cacheType << " " << cache_size << " " << paramSummary << " "
-       << reqs << " " << hits << " "
-       << double(hits)/reqs << endl;
+  const string name = cacheType + " " + std::to_string(cache_size) + " " + params;
+  // nothing was counted, there are no results
+  if(!replay.warm()) {
+    cerr << "the trace ended during the warm-up" << endl;
+    return 1;
+  }
+  replay.printIntervals(cout, name);
+  replay.printSizeClasses(cout, name);
+  const HitCounters total = replay.total();
+  cout << name << " "
+       << total.reqs << " " << total.hits << " "
+       << total.objectHitRatio() << " " << total.byteHitRatio();
+  // sampling rate and standard error of the hit ratio
+  if(sampled)
+    cout << " " << rate << " " << replay.sampleError();
+  cout << endl;
 
   return 0;
 }